@@ -0,0 +1,360 @@
+// micro benchmarks of sqlite3yaw hot paths: bind/get through conv<>, column name lookup,
+// batch_insert/batch_upsert, record_range iteration and load_session_meta.
+//
+// usage: sqlite3yaw-bench [--db=<path>] [--min-time=<seconds>] [--filter=<substring>]
+//   --db        database file, default :memory:, use tmpfs path(/dev/shm/bench.db) for file based runs.
+//               file is deleted and recreated by each benchmark
+//   --min-time  minimal run time of each benchmark, default 0.2
+//   --filter    run only benchmarks whose name contains substring
+//
+// results are written to stdout as JSON, compatible with google benchmark output layout:
+//   {"context": {...}, "benchmarks": [{"name", "iterations", "real_time", "time_unit", "items_per_second"}, ...]}
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <sqlite3yaw.hpp>
+#include <sqlite3yaw_ext.hpp>
+
+namespace
+{
+	using namespace sqlite3yaw;
+	typedef std::vector<std::pair<std::string, std::string>> record;
+
+	struct config
+	{
+		std::string db = ":memory:";
+		double min_time = 0.2;
+		std::string filter;
+	} cfg;
+
+	struct result
+	{
+		std::string name;
+		std::size_t iterations;
+		double ns_per_iteration;
+		double items_per_second;
+	};
+
+	std::vector<result> results;
+
+	session open_db()
+	{
+		if (cfg.db != ":memory:")
+		{
+			for (auto suffix : {"", "-wal", "-shm", "-journal"})
+				std::remove((cfg.db + suffix).c_str());
+		}
+
+		return session(cfg.db);
+	}
+
+	/// runs body(iterations) with growing iteration count until it takes at least min_time,
+	/// body processes items_per_iteration items per iteration
+	void run(const std::string & name, std::size_t items_per_iteration, const std::function<void(std::size_t)> & body)
+	{
+		if (!cfg.filter.empty() && name.find(cfg.filter) == std::string::npos)
+			return;
+
+		std::size_t iterations = 1;
+		for (;;)
+		{
+			auto start = std::chrono::steady_clock::now();
+			body(iterations);
+			double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (elapsed >= cfg.min_time || iterations >= (std::size_t(1) << 30))
+			{
+				double ns = elapsed * 1e9 / iterations;
+				double items = elapsed > 0 ? iterations * items_per_iteration / elapsed : 0;
+				results.push_back({name, iterations, ns, items});
+				std::cerr << name << ": " << ns << " ns/iter\n";
+				return;
+			}
+
+			double factor = elapsed > 0 ? cfg.min_time * 1.4 / elapsed : 100;
+			iterations = static_cast<std::size_t>(iterations * std::min(100.0, std::max(2.0, factor)));
+		}
+	}
+
+	std::string column_names(int ncols)
+	{
+		std::string names;
+		for (int i = 0; i < ncols; ++i)
+		{
+			if (i) names += ", ";
+			names += "column_" + std::to_string(i);
+		}
+
+		return names;
+	}
+
+	/// bind through conv<> per type
+	void bench_bind()
+	{
+		auto ses = open_db();
+		auto stmt = ses.prepare("select ?");
+
+		const std::string text(64, 'x');
+		const std::vector<std::byte> blob(4096, std::byte{1});
+
+		run("bind/int", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) bind(stmt, 1, static_cast<int>(i)); });
+		run("bind/int64", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) bind(stmt, 1, static_cast<sqlite3_int64>(i)); });
+		run("bind/double", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) bind(stmt, 1, i * 0.5); });
+		run("bind/string_copy", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) bind(stmt, 1, text, true); });
+		run("bind/string_static", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) bind(stmt, 1, text); });
+		run("bind/string_view", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) bind(stmt, 1, std::string_view(text)); });
+		run("bind/blob_4k", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) bind(stmt, 1, blob, true); });
+	}
+
+	/// get through conv<> per type
+	void bench_get()
+	{
+		auto ses = open_db();
+		auto stmt = ses.prepare("select 42, 1234567890123, 2.5, printf('%.64c', 'x'), zeroblob(4096)");
+		stmt.step();
+
+		int i32; sqlite3_int64 i64; double d;
+		std::string str; std::string_view sv; std::vector<std::byte> blob;
+
+		run("get/int", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) get(stmt, 0, i32); });
+		run("get/int64", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) get(stmt, 1, i64); });
+		run("get/double", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) get(stmt, 2, d); });
+		run("get/string", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) get(stmt, 3, str); });
+		run("get/string_view", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) get(stmt, 3, sv); });
+		run("get/blob_4k", 1, [&](std::size_t n) { for (std::size_t i = 0; i < n; ++i) get(stmt, 4, blob); });
+	}
+
+	/// column_name_to_index of last column by result width
+	void bench_column_name_to_index()
+	{
+		auto ses = open_db();
+		for (int width : {4, 16, 64, 256})
+		{
+			std::string select = "select ";
+			for (int i = 0; i < width; ++i)
+				select += (i ? ", " : "") + std::to_string(i) + " as column_" + std::to_string(i);
+
+			auto stmt = ses.prepare(select);
+			auto name = "column_" + std::to_string(width - 1);
+
+			run("column_name_to_index/" + std::to_string(width), 1, [&](std::size_t n)
+			{
+				for (std::size_t i = 0; i < n; ++i)
+					if (column_name_to_index(stmt, name) < 0) std::abort();
+			});
+		}
+	}
+
+	void create_test_table(session & ses)
+	{
+		ses.exec("create table test(id integer primary key, name text, value real, descr text)");
+	}
+
+	record make_record(std::size_t id)
+	{
+		return {{"id", std::to_string(id)}, {"name", "name " + std::to_string(id)},
+		        {"value", std::to_string(id * 0.25)}, {"descr", "description"}};
+	}
+
+	void bench_batch()
+	{
+		const std::size_t rows = 10000;
+		std::vector<record> records;
+		records.reserve(rows);
+		for (std::size_t i = 0; i < rows; ++i)
+			records.push_back(make_record(i));
+
+		auto ses = open_db();
+		create_test_table(ses);
+		auto meta = load_table_meta(ses, "test");
+
+		run("batch_insert/10000", rows, [&](std::size_t n)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				transaction tr(ses);
+				ses.exec("delete from test");
+				batch_insert(records, ses, meta);
+				tr.commit();
+			}
+		});
+
+		run("batch_insert_multirow/10000", rows, [&](std::size_t n)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				transaction tr(ses);
+				ses.exec("delete from test");
+				batch_insert_multirow(records, ses, meta);
+				tr.commit();
+			}
+		});
+
+		// explicit rows per statement, to compare with automatic choice(detail::MultirowAutoMaxRows)
+		for (std::size_t rows_per_statement : {1, 8, 16, 64, 256, 1024})
+		{
+			run("batch_insert_multirow/10000/rows_" + std::to_string(rows_per_statement), rows, [&](std::size_t n)
+			{
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					transaction tr(ses);
+					ses.exec("delete from test");
+					batch_insert_multirow(records, ses, meta, rows_per_statement);
+					tr.commit();
+				}
+			});
+		}
+
+		// hit ratio - percentage of records already present in table, they are updated, others - inserted
+		for (int hit : {0, 50, 100})
+		{
+			const std::size_t present = rows * hit / 100;
+			run("batch_upsert/10000/hit_" + std::to_string(hit), rows, [&](std::size_t n)
+			{
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					transaction tr(ses);
+					ses.exec("delete from test where id >= " + std::to_string(present));
+					batch_upsert(records, ses, meta);
+					tr.commit();
+				}
+			});
+		}
+	}
+
+	void bench_record_range()
+	{
+		const std::size_t rows = 10000;
+		auto ses = open_db();
+		create_test_table(ses);
+		{
+			std::vector<record> records;
+			for (std::size_t i = 0; i < rows; ++i)
+				records.push_back(make_record(i));
+
+			transaction tr(ses);
+			batch_insert(records, ses, load_table_meta(ses, "test"));
+			tr.commit();
+		}
+
+		auto stmt = ses.prepare("select id, name, value from test");
+		auto read = [](statement & stmt)
+		{
+			return std::make_tuple(get<int>(stmt, 0), get<std::string>(stmt, 1), get<double>(stmt, 2));
+		};
+
+		run("record_range/10000", rows, [&](std::size_t n)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				double sum = 0;
+				for (auto && rec : make_record_range(stmt, read))
+					sum += std::get<2>(rec);
+
+				stmt.reset();
+				if (sum < 0) std::abort();
+			}
+		});
+	}
+
+	void bench_load_session_meta()
+	{
+		for (int tables : {100, 1000, 3000})
+		{
+			auto ses = open_db();
+			{
+				transaction tr(ses);
+				for (int i = 0; i < tables; ++i)
+					ses.exec("create table t" + std::to_string(i) + "(id integer primary key, " + column_names(8) + ")");
+				tr.commit();
+			}
+
+			run("load_session_meta/" + std::to_string(tables), tables, [&](std::size_t n)
+			{
+				for (std::size_t i = 0; i < n; ++i)
+					if (load_session_meta(ses).size() != static_cast<std::size_t>(tables)) std::abort();
+			});
+		}
+	}
+
+	std::string json_escape(const std::string & str)
+	{
+		std::string ret;
+		for (char ch : str)
+		{
+			if (ch == '"' || ch == '\\') ret += '\\';
+			ret += ch;
+		}
+
+		return ret;
+	}
+
+	void write_json(std::ostream & os)
+	{
+		os << "{\n  \"context\": {\n"
+		   << "    \"library\": \"sqlite3yaw\",\n"
+		   << "    \"sqlite_version\": \"" << sqlite3_libversion() << "\",\n"
+		   << "    \"database\": \"" << json_escape(cfg.db) << "\",\n"
+		   << "    \"min_time\": " << cfg.min_time << "\n"
+		   << "  },\n  \"benchmarks\": [";
+
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			auto & r = results[i];
+			os << (i ? "," : "") << "\n    {"
+			   << "\"name\": \"" << json_escape(r.name) << "\", "
+			   << "\"iterations\": " << r.iterations << ", "
+			   << "\"real_time\": " << r.ns_per_iteration << ", "
+			   << "\"time_unit\": \"ns\", "
+			   << "\"items_per_second\": " << r.items_per_second << "}";
+		}
+
+		os << "\n  ]\n}\n";
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		auto value = [&arg](const char * prefix) { return arg.substr(std::strlen(prefix)); };
+
+		if      (arg.rfind("--db=", 0) == 0)       cfg.db = value("--db=");
+		else if (arg.rfind("--min-time=", 0) == 0) cfg.min_time = std::stod(value("--min-time="));
+		else if (arg.rfind("--filter=", 0) == 0)   cfg.filter = value("--filter=");
+		else
+		{
+			std::cerr << "unknown argument: " << arg << "\n";
+			return 1;
+		}
+	}
+
+	try
+	{
+		bench_bind();
+		bench_get();
+		bench_column_name_to_index();
+		bench_batch();
+		bench_record_range();
+		bench_load_session_meta();
+	}
+	catch (std::exception & ex)
+	{
+		std::cerr << "benchmark failed: " << ex.what() << "\n";
+		return 1;
+	}
+
+	write_json(std::cout);
+	return 0;
+}
@@ -1,13 +1,28 @@
 #pragma once
 #include <sqlite3yaw/statement.hpp>
 #include <sqlite3yaw/session.hpp>
+#include <sqlite3yaw/statement_cache.hpp>
+#include <sqlite3yaw/status.hpp>
 #include <sqlite3yaw/handle.hpp>
+#include <sqlite3yaw/session_pool.hpp>
+#include <sqlite3yaw/async_writer.hpp>
+#include <sqlite3yaw/backup.hpp>
+#include <sqlite3yaw/checkpoint_scheduler.hpp>
+#include <sqlite3yaw/change_feed.hpp>
+#include <sqlite3yaw/instrumentation.hpp>
 #include <sqlite3yaw/transaction.hpp>
 
 #include <sqlite3yaw/convert.hpp>
 #include <sqlite3yaw/bind.hpp>
 #include <sqlite3yaw/query.hpp>
 #include <sqlite3yaw/get_iterator.hpp>
+#include <sqlite3yaw/typed_query.hpp>
+#include <sqlite3yaw/column_batch.hpp>
+#include <sqlite3yaw/record_traits.hpp>
+#include <sqlite3yaw/record_mapping.hpp>
+#include <sqlite3yaw/functions.hpp>
+#include <sqlite3yaw/vtab.hpp>
+#include <sqlite3yaw/array.hpp>
 
 #include <sqlite3yaw/convert_stdord.hpp>
 #include <sqlite3yaw/convert_boost.hpp>
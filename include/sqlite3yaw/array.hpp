@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sqlite3yaw/sqlite3inc.h>
+#include <sqlite3yaw/exceptions.hpp>
+#include <sqlite3yaw/session.hpp>
+#include <sqlite3yaw/convert.hpp>
+
+#if __cplusplus > 201703L && __has_include(<span>)
+#include <span>
+#endif
+
+/// array parameters: contiguous C++ array bound as single pointer parameter(sqlite3_bind_pointer),
+/// exposed to SQL by table-valued function registered with create_array_function:
+///
+///   create_array_function(ses);
+///   auto stmt = ses.prepare("select * from t where id in carray(?)");
+///   bind(stmt, 1, ids);   // std::vector<sqlite3_int64>, array_view, std::span, std::vector<std::string>, ...
+///
+/// one prepared statement serves any array size. elements are converted by conv<Elem> when read,
+/// so any type with conv<> can be element type(except std::byte - vector<std::byte> is blob).
+/// vector is copied when bound as rvalue or with forceCopy. views(array_view, std::span) don't own data,
+/// they are copied only with forceCopy: bind(stmt, 1, as_array(p, n)) references array.
+/// not copied array must stay alive and unchanged until statement is reset or rebound.
+namespace sqlite3yaw
+{
+	/// non owning view of contiguous array, C++17 replacement for std::span<const Elem>
+	template <class Elem>
+	struct array_view
+	{
+		const Elem * data;
+		std::size_t size;
+	};
+
+	template <class Elem>
+	array_view<Elem> as_array(const Elem * data, std::size_t size) noexcept
+	{
+		return {data, size};
+	}
+
+	template <class Elem, class allocator>
+	array_view<Elem> as_array(const std::vector<Elem, allocator> & vec) noexcept
+	{
+		return {vec.data(), vec.size()};
+	}
+
+	namespace detail
+	{
+		/// pointer type tag of array parameters, carray function accepts only pointers with this tag
+		inline constexpr const char array_pointer_type[] = "sqlite3yaw::array";
+
+		/// bound array: element accessor is instantiated for element type at bind
+		struct array_pointer
+		{
+			const void * data;
+			std::size_t size;
+			void (* column)(const void * data, std::size_t idx, sqlite3_context * ctx);
+			void (* destroy)(array_pointer * ptr) noexcept;
+		};
+
+		template <class Elem>
+		struct array_copy : array_pointer
+		{
+			std::vector<Elem> values;
+		};
+
+		template <class Elem>
+		void array_column(const void * data, std::size_t idx, sqlite3_context * ctx)
+		{
+			// array outlives statement step, strings are not copied
+			convert::ibind b(ctx, true);
+			convert::conv<Elem>::put(static_cast<const Elem *>(data)[idx], false, b);
+		}
+
+		inline void destroy_array_pointer(array_pointer * ptr) noexcept
+		{
+			delete ptr;
+		}
+
+		template <class Elem>
+		void destroy_array_copy(array_pointer * ptr) noexcept
+		{
+			delete static_cast<array_copy<Elem> *>(ptr);
+		}
+
+		inline void release_array_pointer(void * ptr) noexcept
+		{
+			auto * arr = static_cast<array_pointer *>(ptr);
+			arr->destroy(arr);
+		}
+
+		template <class Elem>
+		void bind_array(convert::ibind & b, const Elem * data, std::size_t size, bool copy)
+		{
+			static_assert(!std::is_same<Elem, std::byte>::value, "byte array is blob, not array parameter");
+			array_pointer * arr;
+			if (copy)
+			{
+				auto * holder = new array_copy<Elem>();
+				holder->values.assign(data, data + size);
+				holder->data = holder->values.data();
+				holder->destroy = &destroy_array_copy<Elem>;
+				arr = holder;
+			}
+			else
+			{
+				arr = new array_pointer();
+				arr->data = data;
+				arr->destroy = &destroy_array_pointer;
+			}
+
+			arr->size = size;
+			arr->column = &array_column<Elem>;
+			// released by sqlite, also if binding fails
+			b.bind_pointer(arr, array_pointer_type, &release_array_pointer);
+		}
+
+		/// eponymous-only table-valued function: carray(?) - rows with value column, one per array element.
+		/// rowid is 1-based element index
+		struct array_module
+		{
+			enum { value_column, pointer_column };
+
+			struct cursor : sqlite3_vtab_cursor
+			{
+				const array_pointer * arr;
+				std::size_t pos, size;
+			};
+
+			static int connect(sqlite3 * db, void *, int, const char * const *, sqlite3_vtab ** out, char **)
+			{
+				int res = sqlite3_declare_vtab(db, "create table x(value, pointer hidden)");
+				if (res != SQLITE_OK) return res;
+
+				auto * vtab = new (std::nothrow) sqlite3_vtab();
+				if (!vtab) return SQLITE_NOMEM;
+
+				*out = vtab;
+				return SQLITE_OK;
+			}
+
+			static int disconnect(sqlite3_vtab * vtab)
+			{
+				delete vtab;
+				return SQLITE_OK;
+			}
+
+			/// array argument is required: plan without it is rejected
+			static int best_index(sqlite3_vtab *, sqlite3_index_info * info)
+			{
+				for (int i = 0; i < info->nConstraint; ++i)
+				{
+					auto & cons = info->aConstraint[i];
+					if (cons.iColumn != pointer_column || cons.op != SQLITE_INDEX_CONSTRAINT_EQ)
+						continue;
+					if (!cons.usable)
+						return SQLITE_CONSTRAINT;
+
+					info->aConstraintUsage[i].argvIndex = 1;
+					info->aConstraintUsage[i].omit = 1;
+					info->idxNum = 1;
+					info->estimatedCost = 1;
+					info->estimatedRows = 100;
+					return SQLITE_OK;
+				}
+
+				info->idxNum = 0;
+				info->estimatedCost = 2147483647;
+				info->estimatedRows = 2147483647;
+				return SQLITE_OK;
+			}
+
+			static int open(sqlite3_vtab *, sqlite3_vtab_cursor ** out)
+			{
+				auto * cur = new (std::nothrow) cursor();
+				if (!cur) return SQLITE_NOMEM;
+
+				*out = cur;
+				return SQLITE_OK;
+			}
+
+			static int close(sqlite3_vtab_cursor * cur)
+			{
+				delete static_cast<cursor *>(cur);
+				return SQLITE_OK;
+			}
+
+			/// not an array pointer(NULL, other value, pointer of other type) - empty table
+			static int filter(sqlite3_vtab_cursor * vcur, int idxNum, const char *, int argc, sqlite3_value ** argv)
+			{
+				auto & cur = *static_cast<cursor *>(vcur);
+				cur.arr = idxNum && argc > 0 ? static_cast<const array_pointer *>(sqlite3_value_pointer(argv[0], array_pointer_type)) : nullptr;
+				cur.pos = 0;
+				cur.size = cur.arr ? cur.arr->size : 0;
+				return SQLITE_OK;
+			}
+
+			static int next(sqlite3_vtab_cursor * cur)
+			{
+				++static_cast<cursor *>(cur)->pos;
+				return SQLITE_OK;
+			}
+
+			static int eof(sqlite3_vtab_cursor * vcur)
+			{
+				auto & cur = *static_cast<cursor *>(vcur);
+				return cur.pos >= cur.size;
+			}
+
+			static int column(sqlite3_vtab_cursor * vcur, sqlite3_context * ctx, int col)
+			{
+				auto & cur = *static_cast<cursor *>(vcur);
+				if (col != value_column)
+					return SQLITE_OK;   // pointer is not readable, NULL
+
+				try
+				{
+					cur.arr->column(cur.arr->data, cur.pos, ctx);
+				}
+				catch (std::bad_alloc &)
+				{
+					sqlite3_result_error_nomem(ctx);
+				}
+				catch (std::exception & ex)
+				{
+					sqlite3_result_error(ctx, ex.what(), -1);
+				}
+
+				return SQLITE_OK;
+			}
+
+			static int rowid(sqlite3_vtab_cursor * vcur, sqlite3_int64 * out)
+			{
+				*out = static_cast<sqlite3_int64>(static_cast<cursor *>(vcur)->pos + 1);
+				return SQLITE_OK;
+			}
+
+			static sqlite3_module make_module() noexcept
+			{
+				sqlite3_module mod;
+				std::memset(&mod, 0, sizeof(mod));
+				mod.iVersion = 1;
+				mod.xCreate = nullptr;  // eponymous-only
+				mod.xConnect = &connect;
+				mod.xBestIndex = &best_index;
+				mod.xDisconnect = &disconnect;
+				mod.xDestroy = &disconnect;
+				mod.xOpen = &open;
+				mod.xClose = &close;
+				mod.xFilter = &filter;
+				mod.xNext = &next;
+				mod.xEof = &eof;
+				mod.xColumn = &column;
+				mod.xRowid = &rowid;
+				return mod;
+			}
+
+			inline static const sqlite3_module module = make_module();
+		};
+	}
+
+	/// registers table-valued function name over array parameters, see top of file.
+	/// named carray by default, like sqlite carray extension, but it only accepts arrays bound by sqlite3yaw
+	inline void create_array_function(session & ses, const char * name = "carray")
+	{
+		int res = sqlite3_create_module_v2(ses.native(), name, &detail::array_module::module, nullptr, nullptr);
+		if (res != SQLITE_OK)
+			throw sqlite_exterror(res, ses.native());
+	}
+
+	namespace convert
+	{
+		template <class Elem>
+		struct is_view<array_view<Elem>> : std::true_type {};
+
+		template <class Elem>
+		struct conv<array_view<Elem>>
+		{
+			static void put(array_view<Elem> val, bool temp, ibind & b) { detail::bind_array(b, val.data, val.size, temp); }
+		};
+
+		template <class Elem, class allocator>
+		struct conv<std::vector<Elem, allocator>>
+		{
+			typedef std::vector<Elem, allocator> vector;
+			static void put(const vector & val, bool temp, ibind & b) { detail::bind_array(b, val.data(), val.size(), temp); }
+		};
+
+#if __cplusplus > 201703L && __has_include(<span>)
+		template <class Elem, std::size_t Extent>
+		struct conv<std::span<Elem, Extent>>
+		{
+			typedef std::span<Elem, Extent> span;
+			static void put(span val, bool temp, ibind & b) { detail::bind_array<std::remove_cv_t<Elem>>(b, val.data(), val.size(), temp); }
+		};
+#endif
+	}
+}
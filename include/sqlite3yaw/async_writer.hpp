@@ -0,0 +1,273 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sqlite3yaw/session.hpp>
+
+namespace sqlite3yaw
+{
+	struct async_writer_options
+	{
+		/// maximum number of jobs committed in one transaction
+		std::size_t max_batch = 256;
+		/// how long writer waits for more jobs after first one in group, before commit
+		std::chrono::microseconds max_latency = std::chrono::milliseconds(2);
+	};
+
+	/// asynchronous single writer with group commit.
+	/// owns session and executes write jobs on dedicated thread.
+	/// queued jobs are coalesced into one "begin immediate" transaction(one fsync),
+	/// group is committed when it has max_batch jobs or max_latency passed since first job of group.
+	///
+	/// each job runs inside it's own savepoint, if job throws - only it's changes are rolled back
+	/// and exception is passed into it's future, other jobs of group are not affected.
+	/// unless error rolled back whole transaction(ON CONFLICT ROLLBACK, IOERR, ...) - then earlier jobs of group fail
+	/// with same exception, and following jobs run in new transaction.
+	/// future of successful job becomes ready only after group is committed.
+	///
+	/// jobs must not begin/commit/rollback transactions by themselves.
+	class async_writer
+	{
+		struct job_base
+		{
+			/// run finished, job waits for commit
+			bool succeeded = false;
+
+			virtual ~job_base() = default;
+			/// executes job, result is stored until commit
+			virtual void run(session & ses) = 0;
+			/// group committed, publish result
+			virtual void commit() noexcept = 0;
+			virtual void fail(std::exception_ptr ex) noexcept = 0;
+		};
+
+		template <class Result, class Functor>
+		struct job : job_base
+		{
+			Functor func;
+			std::promise<Result> promise;
+			std::optional<std::conditional_t<std::is_void<Result>::value, bool, Result>> result;
+
+			job(Functor func_) : func(std::move(func_)) {}
+
+			void run(session & ses) override
+			{
+				if constexpr (std::is_void<Result>::value)
+				{
+					func(ses);
+					result = true;
+				}
+				else
+					result.emplace(func(ses));
+			}
+
+			void commit() noexcept override
+			{
+				if constexpr (std::is_void<Result>::value)
+					promise.set_value();
+				else
+					promise.set_value(std::move(*result));
+			}
+
+			void fail(std::exception_ptr ex) noexcept override
+			{
+				promise.set_exception(std::move(ex));
+			}
+		};
+
+		typedef std::unique_ptr<job_base> job_ptr;
+
+		session ses;
+		async_writer_options opts;
+
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::deque<job_ptr> queue;
+		bool stopping = false;
+
+		std::thread thread;
+
+	private:
+		/// waits for first job, then collects group up to max_batch or max_latency.
+		/// returns empty group if stopping and queue is empty
+		std::vector<job_ptr> collect_group()
+		{
+			std::vector<job_ptr> group;
+			std::unique_lock<std::mutex> lk(mutex);
+			cond.wait(lk, [this] { return stopping || !queue.empty(); });
+			if (queue.empty()) return group;
+
+			auto deadline = std::chrono::steady_clock::now() + opts.max_latency;
+			for (;;)
+			{
+				while (!queue.empty() && group.size() < opts.max_batch)
+				{
+					group.push_back(std::move(queue.front()));
+					queue.pop_front();
+				}
+
+				if (group.size() >= opts.max_batch || stopping)
+					break;
+
+				if (!cond.wait_until(lk, deadline, [this] { return stopping || !queue.empty(); }))
+					break;
+			}
+
+			return group;
+		}
+
+		/// commits jobs [first, last) that succeeded, if commit fails - they fail with commit error
+		void commit_jobs(std::vector<job_ptr> & group, std::size_t first, std::size_t last) noexcept
+		{
+			try
+			{
+				ses.exec("commit");
+			}
+			catch (...)
+			{
+				ses.exec_ex("rollback");
+				fail_succeeded(group, first, last, std::current_exception());
+				return;
+			}
+
+			for (std::size_t i = first; i < last; ++i)
+				if (group[i]->succeeded) group[i]->commit();
+		}
+
+		static void fail_succeeded(std::vector<job_ptr> & group, std::size_t first, std::size_t last, std::exception_ptr ex) noexcept
+		{
+			for (std::size_t i = first; i < last; ++i)
+				if (group[i]->succeeded) group[i]->fail(ex);
+		}
+
+		void execute_group(std::vector<job_ptr> & group) noexcept
+		{
+			// jobs [first, i) run in current transaction, first == npos - no transaction
+			const std::size_t npos = -1;
+			std::size_t first = npos;
+
+			for (std::size_t i = 0; i < group.size(); ++i)
+			{
+				auto & j = group[i];
+				if (first == npos)
+				{
+					try
+					{
+						ses.exec("begin immediate");
+						first = i;
+					}
+					catch (...)
+					{
+						auto ex = std::current_exception();
+						for (; i < group.size(); ++i) group[i]->fail(ex);
+						return;
+					}
+				}
+
+				try
+				{
+					ses.exec("savepoint sqlite3yaw_async_job");
+					j->run(ses);
+					ses.exec("release sqlite3yaw_async_job");
+					j->succeeded = true;
+				}
+				catch (...)
+				{
+					auto ex = std::current_exception();
+					if (ses.get_autocommit())
+					{
+						// error rolled back whole transaction(ON CONFLICT ROLLBACK, IOERR, NOMEM, BUSY, ...):
+						// changes of earlier jobs are lost, they fail with same error. next job starts new transaction
+						fail_succeeded(group, first, i, ex);
+						first = npos;
+					}
+					else
+					{
+						ses.exec_ex("rollback to sqlite3yaw_async_job");
+						ses.exec_ex("release sqlite3yaw_async_job");
+					}
+
+					j->fail(std::move(ex));
+				}
+			}
+
+			if (first != npos)
+				commit_jobs(group, first, group.size());
+		}
+
+		void thread_proc() noexcept
+		{
+			for (;;)
+			{
+				std::vector<job_ptr> group;
+				try
+				{
+					group = collect_group();
+				}
+				catch (...)
+				{
+					// out of memory: jobs already taken from queue are destroyed, their futures get broken_promise
+					continue;
+				}
+
+				if (group.empty()) return;
+
+				execute_group(group);
+			}
+		}
+
+	public:
+		async_writer(const async_writer &) = delete;
+		async_writer & operator =(const async_writer &) = delete;
+
+		explicit async_writer(session ses_, const async_writer_options & opts_ = {})
+			: ses(std::move(ses_)), opts(opts_)
+		{
+			if (opts.max_batch == 0) opts.max_batch = 1;
+			thread = std::thread(&async_writer::thread_proc, this);
+		}
+
+		/// executes all already submitted jobs and stops writer thread
+		~async_writer() noexcept
+		{
+			{
+				std::lock_guard<std::mutex> lk(mutex);
+				stopping = true;
+			}
+
+			cond.notify_one();
+			thread.join();
+		}
+
+		/// submits job: Functor(session &) -> Result, can be called from any thread.
+		/// returned future is ready after job's group is committed, or job/commit failed
+		template <class Functor>
+		auto submit(Functor func) -> std::future<std::invoke_result_t<Functor &, session &>>
+		{
+			typedef std::invoke_result_t<Functor &, session &> Result;
+			auto j = std::make_unique<job<Result, Functor>>(std::move(func));
+			auto future = j->promise.get_future();
+
+			{
+				std::lock_guard<std::mutex> lk(mutex);
+				if (stopping) throw std::logic_error("async_writer: submit after stop");
+				queue.push_back(std::move(j));
+			}
+
+			cond.notify_one();
+			return future;
+		}
+	};
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <sqlite3yaw/sqlite3inc.h>
+#include <sqlite3yaw/exceptions.hpp>
+#include <sqlite3yaw/session.hpp>
+
+namespace sqlite3yaw
+{
+	struct backup_options
+	{
+		/// pages copied by one sqlite3_backup_step, source is read locked only during step. -1 - all at once
+		int pages_per_step = 256;
+		/// pause between steps, gives writers of source time to proceed
+		std::chrono::milliseconds step_delay {0};
+		/// pause before retrying step which failed with SQLITE_BUSY/SQLITE_LOCKED
+		std::chrono::milliseconds busy_delay {10};
+		/// how many times in row busy step is retried before sqlite_error is thrown, -1 - unlimited
+		int busy_retries = -1;
+		/// called after each successful step with remaining and total page count,
+		/// return false to cancel backup(backup::run returns false)
+		std::function<bool(int remaining, int pagecount)> progress;
+	};
+
+	/// online backup, wrapper around sqlite3_backup_init/step/finish.
+	/// copies database src_name of src into database dest_name of dest page by page,
+	/// source can be used by other connections between steps. if source is modified through other connection -
+	/// backup restarts from beginning on next step, modifications through src connection itself are applied to backup.
+	class backup
+	{
+		//functor that can finish sqlite3_backup handles. For unique_ptr
+		struct AutoFinish
+		{
+			void operator ()(sqlite3_backup * bk) const noexcept
+			{
+				sqlite3_backup_finish(bk);
+			}
+		};
+
+		std::unique_ptr<sqlite3_backup, AutoFinish> bk;
+		sqlite3 * dest;
+
+	public:
+		backup(backup && r) = default;
+		backup & operator =(backup && r) = default;
+
+		backup(session & dest, session & src)
+			: backup(dest, "main", src, "main") {}
+
+		backup(session & dest_, const char * dest_name, session & src, const char * src_name)
+			: dest(dest_.native())
+		{
+			bk.reset(sqlite3_backup_init(dest, dest_name, src.native(), src_name));
+			if (!bk) throw sqlite_exterror(sqlite3_errcode(dest), dest);
+		}
+
+		sqlite3_backup * native() const noexcept { return bk.get(); }
+
+		/// copies up to pages pages, -1 - all remaining.
+		/// returns SQLITE_DONE when backup is complete, SQLITE_OK if there are more pages,
+		/// SQLITE_BUSY/SQLITE_LOCKED if source or destination is locked(step can be retried), throws on other errors
+		int step(int pages)
+		{
+			int res = sqlite3_backup_step(bk.get(), pages);
+			if (res == SQLITE_DONE || res == SQLITE_OK || res == SQLITE_BUSY || res == SQLITE_LOCKED)
+				return res;
+
+			throw sqlite_exterror(res, dest);
+		}
+
+		/// values are updated by step
+		int remaining() const noexcept { return sqlite3_backup_remaining(bk.get()); }
+		int pagecount() const noexcept { return sqlite3_backup_pagecount(bk.get()); }
+
+		/// releases backup handle, throws if backup failed
+		void finish()
+		{
+			int res = sqlite3_backup_finish(bk.release());
+			if (res != SQLITE_OK)
+				throw sqlite_exterror(res, dest);
+		}
+
+		/// steps until backup is complete, see backup_options. finish is not called.
+		/// cancel - optional flag checked before each step.
+		/// returns true when backup is complete, false if cancelled
+		bool run(const backup_options & opts = {}, const std::atomic<bool> * cancel = nullptr)
+		{
+			int busy = 0;
+			for (;;)
+			{
+				if (cancel && cancel->load(std::memory_order_relaxed))
+					return false;
+
+				int res = step(opts.pages_per_step);
+				if (res == SQLITE_BUSY || res == SQLITE_LOCKED)
+				{
+					if (opts.busy_retries >= 0 && busy++ >= opts.busy_retries)
+						throw sqlite_exterror(res, dest);
+
+					std::this_thread::sleep_for(opts.busy_delay);
+					continue;
+				}
+
+				busy = 0;
+				if (opts.progress && !opts.progress(remaining(), pagecount()))
+					return false;
+
+				if (res == SQLITE_DONE)
+					return true;
+
+				if (opts.step_delay.count())
+					std::this_thread::sleep_for(opts.step_delay);
+			}
+		}
+	};
+
+	/// backups database db_name of src into file path(created or overwritten), returns false if cancelled by progress
+	inline bool backup_database(session & src, const std::string & path, const backup_options & opts = {}, const char * db_name = "main")
+	{
+		session dest(path);
+		backup bk(dest, "main", src, db_name);
+		bool done = bk.run(opts);
+		bk.finish();
+		return done;
+	}
+
+	/// VACUUM db_name INTO path(sqlite 3.27+): writes compacted copy of database into new file,
+	/// file must not exist or be empty. unlike backup - it's one statement, holding read transaction till end
+	inline void vacuum_into(session & ses, const std::string & path, const char * db_name = "main")
+	{
+		std::string cmd = "vacuum \"";
+		for (const char * p = db_name; *p; ++p)
+		{
+			if (*p == '"') cmd += '"';
+			cmd += *p;
+		}
+		cmd += "\" into ?";
+
+		auto stmt = ses.prepare(cmd);
+		stmt.bind_text(1, path.c_str(), static_cast<int>(path.size()), false);
+		stmt.step();
+	}
+
+#if SQLITE_VERSION_NUMBER >= 3036000 && !defined(SQLITE_OMIT_DESERIALIZE)
+	/// in-memory image of database, see serialize/deserialize
+	class serialized_database
+	{
+		struct Free
+		{
+			void operator ()(unsigned char * ptr) const noexcept { sqlite3_free(ptr); }
+		};
+
+		std::unique_ptr<unsigned char, Free> ptr;
+		sqlite3_int64 sz = 0;
+
+	public:
+		serialized_database() = default;
+		/// takes ownership of memory allocated by sqlite3_malloc
+		serialized_database(unsigned char * data, sqlite3_int64 size) noexcept : ptr(data), sz(size) {}
+
+		const unsigned char * data() const noexcept { return ptr.get(); }
+		sqlite3_int64 size() const noexcept { return sz; }
+		bool empty() const noexcept { return !ptr; }
+
+		/// releases ownership, memory must be freed with sqlite3_free
+		unsigned char * release() noexcept { sz = 0; return ptr.release(); }
+	};
+
+	namespace detail
+	{
+		/// in-memory database can't be in WAL mode, image of WAL database has file format version bytes 18, 19 set to 2,
+		/// reset them to rollback journal mode(1)
+		inline void reset_wal_header(unsigned char * data, sqlite3_int64 size) noexcept
+		{
+			if (size >= 20 && data[18] == 2 && data[19] == 2)
+				data[18] = data[19] = 1;
+		}
+	}
+
+	/// serializes database db_name of ses into memory, same bytes as database file would have
+	inline serialized_database serialize(session & ses, const char * db_name = "main")
+	{
+		sqlite3_int64 size = 0;
+		auto * data = sqlite3_serialize(ses.native(), db_name, &size, 0);
+		if (!data && size != 0)
+			throw sqlite_exterror(SQLITE_NOMEM, ses.native());
+
+		return {data, size};
+	}
+
+	/// replaces database db_name of ses with in-memory image, image is copied.
+	/// resulting database is in memory, resizable and can be modified unless readonly.
+	/// image of WAL mode database is switched to rollback journal mode
+	inline void deserialize(session & ses, const unsigned char * data, sqlite3_int64 size, bool readonly = false, const char * db_name = "main")
+	{
+		auto * copy = static_cast<unsigned char *>(sqlite3_malloc64(static_cast<sqlite3_uint64>(size ? size : 1)));
+		if (!copy) throw sqlite_exterror(SQLITE_NOMEM);
+		if (size) std::memcpy(copy, data, static_cast<std::size_t>(size));
+		detail::reset_wal_header(copy, size);
+
+		unsigned flags = SQLITE_DESERIALIZE_FREEONCLOSE | (readonly ? SQLITE_DESERIALIZE_READONLY : SQLITE_DESERIALIZE_RESIZEABLE);
+		// on failure sqlite frees copy itself because of FREEONCLOSE
+		int res = sqlite3_deserialize(ses.native(), db_name, copy, size, size, flags);
+		if (res != SQLITE_OK)
+			throw sqlite_exterror(res, ses.native());
+	}
+
+	/// replaces database db_name of ses with in-memory image, ownership of image memory is taken
+	inline void deserialize(session & ses, serialized_database && image, bool readonly = false, const char * db_name = "main")
+	{
+		auto size = image.size();
+		auto * data = image.release();
+		detail::reset_wal_header(data, size);
+
+		unsigned flags = SQLITE_DESERIALIZE_FREEONCLOSE | (readonly ? SQLITE_DESERIALIZE_READONLY : SQLITE_DESERIALIZE_RESIZEABLE);
+		int res = sqlite3_deserialize(ses.native(), db_name, data, size, size, flags);
+		if (res != SQLITE_OK)
+			throw sqlite_exterror(res, ses.native());
+	}
+#endif
+
+	/// backup running on it's own thread.
+	/// source is opened by path with separate read-only connection, so owning session and it's writers are
+	/// never blocked for longer than one step(pages_per_step pages). keep step small and step_delay non-zero
+	/// for busy sources: write through other connection restarts backup from beginning.
+	///
+	/// destructor cancels unfinished backup and waits for thread, partially written destination is left as is
+	class background_backup
+	{
+		std::atomic<bool> cancelled = {false};
+		std::atomic<bool> finished = {false};
+		std::atomic<int> remaining_ = {-1};
+		std::atomic<int> pagecount_ = {-1};
+		std::exception_ptr error;
+		bool completed = false;
+		std::thread thread;
+
+	private:
+		void thread_proc(std::string src_path, std::string dest_path, backup_options opts) noexcept
+		{
+			try
+			{
+				session src(src_path, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI);
+				session dest(dest_path);
+				backup bk(dest, src);
+
+				auto user_progress = std::move(opts.progress);
+				opts.progress = [this, &user_progress](int remaining, int pagecount)
+				{
+					remaining_.store(remaining, std::memory_order_relaxed);
+					pagecount_.store(pagecount, std::memory_order_relaxed);
+					return !user_progress || user_progress(remaining, pagecount);
+				};
+
+				completed = bk.run(opts, &cancelled);
+				bk.finish();
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			finished.store(true, std::memory_order_release);
+		}
+
+	public:
+		background_backup(const background_backup &) = delete;
+		background_backup & operator =(const background_backup &) = delete;
+
+		/// starts backup of database file src_path into dest_path, opts.progress is called on backup thread
+		background_backup(std::string src_path, std::string dest_path, backup_options opts = {})
+		{
+			thread = std::thread(&background_backup::thread_proc, this, std::move(src_path), std::move(dest_path), std::move(opts));
+		}
+
+		/// starts backup of main database of ses, which must be file database
+		background_backup(session & ses, std::string dest_path, backup_options opts = {})
+			: background_backup(source_path(ses), std::move(dest_path), std::move(opts)) {}
+
+		~background_backup() noexcept
+		{
+			cancel();
+			if (thread.joinable()) thread.join();
+		}
+
+		static std::string source_path(session & ses)
+		{
+			const char * path = ses.filename("main");
+			if (!path || !*path)
+				throw std::invalid_argument("background_backup: session database is not a file");
+
+			return path;
+		}
+
+		/// requests cancellation, backup stops before next step
+		void cancel() noexcept { cancelled.store(true, std::memory_order_relaxed); }
+
+		bool done() const noexcept { return finished.load(std::memory_order_acquire); }
+		/// progress as of last step, -1 before first step
+		int remaining() const noexcept { return remaining_.load(std::memory_order_relaxed); }
+		int pagecount() const noexcept { return pagecount_.load(std::memory_order_relaxed); }
+
+		/// waits for backup thread, rethrows backup error.
+		/// returns true if backup completed, false if it was cancelled
+		bool wait()
+		{
+			if (thread.joinable()) thread.join();
+			if (error) std::rethrow_exception(error);
+			return completed;
+		}
+	};
+}
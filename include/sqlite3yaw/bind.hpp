@@ -22,9 +22,10 @@ namespace sqlite3yaw
 
 		// if you get here undefined type conv<Type>
 		// then your type conversion is not registered. see convert.hpp
+		// rvalue views still reference living data, see convert::is_view
 		convert::conv<PureType>::put(
 			std::forward<Type>(val),
-			std::is_rvalue_reference<Type &&>::value || forceCopy,
+			(std::is_rvalue_reference<Type &&>::value && !convert::is_view<PureType>::value) || forceCopy,
 			b);
 	}
 
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sqlite3yaw/session.hpp>
+
+namespace sqlite3yaw
+{
+	namespace detail
+	{
+		/// bounded lock-free ring buffer(D. Vyukov bounded MPMC queue), capacity is rounded up to power of 2.
+		/// items are exchanged by swap: push gives item to ring and receives back previously consumed one,
+		/// so vectors inside items keep their capacity and steady state does not allocate
+		template <class Type>
+		class bounded_ring
+		{
+			struct cell
+			{
+				std::atomic<std::size_t> seq;
+				Type data;
+			};
+
+			static constexpr std::size_t cache_line = 64;
+
+			std::unique_ptr<cell[]> cells;
+			std::size_t mask;
+
+			alignas(cache_line) std::atomic<std::size_t> head = {0}; // next push position
+			alignas(cache_line) std::atomic<std::size_t> tail = {0}; // next pop position
+
+		public:
+			bounded_ring(const bounded_ring &) = delete;
+			bounded_ring & operator =(const bounded_ring &) = delete;
+
+			explicit bounded_ring(std::size_t capacity)
+			{
+				std::size_t size = 2;
+				while (size < capacity) size <<= 1;
+
+				cells.reset(new cell[size]);
+				mask = size - 1;
+				for (std::size_t i = 0; i < size; ++i)
+					cells[i].seq.store(i, std::memory_order_relaxed);
+			}
+
+			std::size_t capacity() const noexcept { return mask + 1; }
+
+			/// returns false if ring is full
+			bool try_push(Type & item) noexcept
+			{
+				using std::swap;
+				std::size_t pos = head.load(std::memory_order_relaxed);
+				for (;;)
+				{
+					cell & c = cells[pos & mask];
+					std::size_t seq = c.seq.load(std::memory_order_acquire);
+					auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+					if (diff == 0)
+					{
+						if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						{
+							swap(c.data, item);
+							c.seq.store(pos + 1, std::memory_order_release);
+							return true;
+						}
+					}
+					else if (diff < 0)
+						return false;
+					else
+						pos = head.load(std::memory_order_relaxed);
+				}
+			}
+
+			/// returns false if ring is empty
+			bool try_pop(Type & item) noexcept
+			{
+				using std::swap;
+				std::size_t pos = tail.load(std::memory_order_relaxed);
+				for (;;)
+				{
+					cell & c = cells[pos & mask];
+					std::size_t seq = c.seq.load(std::memory_order_acquire);
+					auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+					if (diff == 0)
+					{
+						if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						{
+							swap(c.data, item);
+							c.seq.store(pos + mask + 1, std::memory_order_release);
+							return true;
+						}
+					}
+					else if (diff < 0)
+						return false;
+					else
+						pos = tail.load(std::memory_order_relaxed);
+				}
+			}
+		};
+	}
+
+	/// row change, as reported by sqlite3_update_hook
+	struct change_event
+	{
+		int op;                      /// SQLITE_INSERT, SQLITE_UPDATE or SQLITE_DELETE
+		sqlite3_int64 rowid;
+		const std::string * db;      /// "main", "temp" or attached name, owned by change_feed
+		const std::string * table;   /// owned by change_feed, valid while it's alive
+	};
+
+	/// changes of one committed transaction
+	struct change_batch
+	{
+		std::uint64_t txn = 0;       /// sequence number of committed transaction, starting from 1
+		std::vector<change_event> events;
+		/// out of memory while collecting events: events are incomplete, consumer must resync table state
+		bool overflow = false;
+	};
+
+	struct change_feed_options
+	{
+		/// committed transactions waiting for consumers
+		std::size_t queue_capacity = 1024;
+		/// initially reserved events per transaction(buffers grow if needed and keep capacity)
+		std::size_t events_reserve = 1024;
+		/// if queue is full: true - writer spins until consumer frees place, false - transaction is dropped and counted
+		bool block_when_full = false;
+	};
+
+	/// change data capture on top of sqlite3_update_hook/commit_hook/rollback_hook.
+	/// events are collected into preallocated buffer during transaction, on commit whole transaction
+	/// is published to bounded lock-free ring as one change_batch, on rollback it's discarded.
+	/// writer side does no locking and, in steady state, no allocations: per row it's one push_back
+	/// and a pointer compare for table name interning.
+	/// any number of consumer threads can pop batches concurrently.
+	///
+	/// feed takes over update/commit/rollback hooks of session, and restores them to none on destruction.
+	/// session must outlive feed, hooks are called on thread using the session.
+	/// limitations of sqlite hooks apply:
+	///  * WITHOUT ROWID tables and truncate optimization(delete without where) are not reported
+	///  * rollback to savepoint does not call rollback hook, events of rolled back savepoint are still published
+	///  * batch is published from commit hook, before commit is durable; if commit fails afterwards
+	///    sqlite calls rollback hook, but batch is already published
+	class change_feed
+	{
+		session * ses;
+		change_feed_options opts;
+
+		// writer side, touched only from hooks
+		change_batch pending;
+		std::deque<std::string> names;           // interned db/table names, deque - references are stable
+		const char * last_db_ptr = nullptr;
+		const std::string * last_db = nullptr;
+		const char * last_table_ptr = nullptr;
+		const std::string * last_table = nullptr;
+		std::uint64_t txn = 0;
+
+		detail::bounded_ring<change_batch> ring;
+		std::atomic<std::uint64_t> dropped = {0};
+
+	private:
+		const std::string * intern(const char * name)
+		{
+			for (auto & str : names)
+				if (str == name) return &str;
+
+			names.emplace_back(name);
+			return &names.back();
+		}
+
+		/// sqlite passes names stored in it's schema objects, usually same pointers for same table.
+		/// pointer can be reused for other name after schema change, so name is compared too
+		const std::string * intern_cached(const char * name, const char *& last_ptr, const std::string *& last)
+		{
+			if (name != last_ptr || std::strcmp(name, last->c_str()) != 0)
+			{
+				last = intern(name);
+				last_ptr = name;
+			}
+
+			return last;
+		}
+
+		static void on_update(change_feed * self, int op, const char * db, const char * table, sqlite3_int64 rowid) noexcept
+		{
+			try
+			{
+				self->pending.events.push_back({op, rowid,
+					self->intern_cached(db, self->last_db_ptr, self->last_db),
+					self->intern_cached(table, self->last_table_ptr, self->last_table)});
+			}
+			catch (std::bad_alloc &)
+			{
+				// can't throw through sqlite, event is lost - batch is marked
+				self->pending.overflow = true;
+			}
+		}
+
+		static int on_commit(change_feed * self) noexcept
+		{
+			self->publish();
+			return 0;
+		}
+
+		static void on_rollback(change_feed * self) noexcept
+		{
+			self->pending.events.clear();
+			self->pending.overflow = false;
+		}
+
+		void publish() noexcept
+		{
+			if (pending.events.empty() && !pending.overflow) return;
+
+			pending.txn = ++txn;
+			while (!ring.try_push(pending))
+			{
+				if (!opts.block_when_full)
+				{
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					break;
+				}
+
+				std::this_thread::yield();
+			}
+
+			// pending now holds buffer returned from ring(or still own if dropped)
+			pending.events.clear();
+			pending.overflow = false;
+			if (pending.events.capacity() < opts.events_reserve)
+			{
+				try { pending.events.reserve(opts.events_reserve); }
+				catch (std::bad_alloc &) {} // buffer grows on push_back
+			}
+		}
+
+	public:
+		change_feed(const change_feed &) = delete;
+		change_feed & operator =(const change_feed &) = delete;
+
+		explicit change_feed(session & ses_, const change_feed_options & opts_ = {})
+			: ses(&ses_), opts(opts_), ring(opts_.queue_capacity)
+		{
+			pending.events.reserve(opts.events_reserve);
+			ses->update_hook(&change_feed::on_update, this);
+			ses->commit_hook(&change_feed::on_commit, this);
+			ses->rollback_hook(&change_feed::on_rollback, this);
+		}
+
+		~change_feed() noexcept
+		{
+			ses->update_hook<change_feed>(nullptr, nullptr);
+			ses->commit_hook<change_feed>(nullptr, nullptr);
+			ses->rollback_hook<change_feed>(nullptr, nullptr);
+		}
+
+		/// pops next committed transaction into batch, returns false if there is none.
+		/// batch previous events buffer is given back to feed for reuse.
+		/// check batch.overflow: events could be lost if memory ran out during transaction
+		bool try_pop(change_batch & batch) noexcept
+		{
+			batch.events.clear();
+			return ring.try_pop(batch);
+		}
+
+		/// same as try_pop, but waits up to timeout, polling with growing sleeps
+		template <class Rep, class Period>
+		bool pop(change_batch & batch, std::chrono::duration<Rep, Period> timeout)
+		{
+			auto deadline = std::chrono::steady_clock::now() + timeout;
+			std::chrono::microseconds sleep(1);
+
+			for (;;)
+			{
+				if (try_pop(batch)) return true;
+				if (std::chrono::steady_clock::now() >= deadline) return false;
+
+				std::this_thread::sleep_for(sleep);
+				if (sleep < std::chrono::milliseconds(1)) sleep *= 2;
+			}
+		}
+
+		/// number of transactions dropped because queue was full
+		std::uint64_t dropped_transactions() const noexcept { return dropped.load(std::memory_order_relaxed); }
+		std::size_t queue_capacity() const noexcept { return ring.capacity(); }
+	};
+}
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <sqlite3yaw/session.hpp>
+
+namespace sqlite3yaw
+{
+	/// when and how hard to checkpoint WAL of one database, thresholds are in WAL frames(pages).
+	/// mode is chosen by WAL size after commit: >= truncate_frames - TRUNCATE, >= restart_frames - RESTART,
+	/// >= passive_frames - PASSIVE. 0 disables level
+	struct checkpoint_policy
+	{
+		int passive_frames = 1000;
+		int restart_frames = 16000;
+		int truncate_frames = 64000;
+		/// busy timeout of background connection in milliseconds, RESTART/TRUNCATE wait for readers that long
+		int busy_timeout = 1000;
+	};
+
+	struct checkpoint_stats
+	{
+		std::uint64_t passive = 0;               /// checkpoints run in each mode
+		std::uint64_t restart = 0;
+		std::uint64_t truncate = 0;
+		std::uint64_t busy = 0;                  /// checkpoints not completed because of readers/writers
+		std::uint64_t errors = 0;                /// checkpoints failed with error(or background connection failed to open)
+		std::uint64_t frames_checkpointed = 0;
+		std::chrono::nanoseconds time {0};       /// total time spent in checkpoints
+		int last_wal_frames = 0;                 /// WAL size seen by last commit
+	};
+
+	/// WAL checkpoint scheduler.
+	/// watches WAL size of writer session through wal_hook(which replaces wal_autocheckpoint of session),
+	/// and runs checkpoints on background thread with it's own connection, so writer never waits for checkpoint.
+	/// checkpoint mode escalates from PASSIVE to RESTART/TRUNCATE as WAL grows, see checkpoint_policy.
+	/// policy is configured per database name("main", attached name), databases without policy use default one.
+	///
+	/// RESTART/TRUNCATE hold the write lock while they run, give writer session busy_timeout to wait for them.
+	/// writer session must be file database in WAL mode and must outlive scheduler,
+	/// on destruction wal_hook is removed and wal_autocheckpoint of writer is restored to default(1000)
+	class checkpoint_scheduler
+	{
+		struct db_state
+		{
+			std::string filename;
+			checkpoint_policy policy;
+			bool has_policy = false;
+			int pending = -1;                    // requested checkpoint mode, -1 - none
+			checkpoint_stats stats;
+		};
+
+		session * writer;
+		checkpoint_policy default_policy;
+
+		mutable std::mutex mutex;
+		std::condition_variable cond;
+		std::map<std::string, db_state> dbs;
+		bool stopping = false;
+
+		std::thread thread;
+
+	private:
+		static int choose_mode(const checkpoint_policy & policy, int frames) noexcept
+		{
+			if (policy.truncate_frames > 0 && frames >= policy.truncate_frames) return SQLITE_CHECKPOINT_TRUNCATE;
+			if (policy.restart_frames > 0 && frames >= policy.restart_frames)   return SQLITE_CHECKPOINT_RESTART;
+			if (policy.passive_frames > 0 && frames >= policy.passive_frames)   return SQLITE_CHECKPOINT_PASSIVE;
+			return -1;
+		}
+
+		/// called on writer thread after each commit
+		static int on_wal(checkpoint_scheduler * self, sqlite3 * db, const char * dbname, int frames) noexcept
+		{
+			try
+			{
+				std::unique_lock<std::mutex> lk(self->mutex);
+				auto & state = self->dbs[dbname];
+				state.stats.last_wal_frames = frames;
+
+				int mode = choose_mode(state.has_policy ? state.policy : self->default_policy, frames);
+				if (mode <= state.pending) return SQLITE_OK;
+
+				if (state.filename.empty())
+				{
+					const char * filename = sqlite3_db_filename(db, dbname);
+					state.filename = filename ? filename : "";
+				}
+
+				state.pending = mode;
+				lk.unlock();
+				self->cond.notify_one();
+			}
+			catch (...)
+			{
+				// out of memory, checkpoint will be requested by next commit
+			}
+
+			return SQLITE_OK;
+		}
+
+		/// attaches database to background connection if needed
+		static void ensure_attached(session & ses, std::set<std::string> & attached, const std::string & dbname, const std::string & filename)
+		{
+			if (dbname == "main" || !attached.insert(dbname).second)
+				return;
+
+			std::string cmd = "attach database ? as \"";
+			for (char ch : dbname)
+			{
+				if (ch == '"') cmd += '"';
+				cmd += ch;
+			}
+			cmd += '"';
+
+			auto stmt = ses.prepare(cmd);
+			stmt.bind_text(1, filename.c_str(), static_cast<int>(filename.size()), false);
+			stmt.step();
+		}
+
+		void thread_proc(std::string main_filename) noexcept
+		{
+			session ses;
+			std::set<std::string> attached;
+			try
+			{
+				ses.open(main_filename, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI);
+				ses.wal_autocheckpoint(0);
+			}
+			catch (...)
+			{
+				// can't do anything without connection, requests are dropped
+			}
+
+			std::unique_lock<std::mutex> lk(mutex);
+			for (;;)
+			{
+				cond.wait(lk, [this] { return stopping || has_pending(); });
+				if (stopping) return;
+
+				for (auto & item : dbs)
+				{
+					auto & state = item.second;
+					if (state.pending < 0) continue;
+
+					int mode = std::exchange(state.pending, -1);
+					auto & policy = state.has_policy ? state.policy : default_policy;
+					int busy_timeout = policy.busy_timeout;
+					auto dbname = item.first;
+					auto filename = state.filename;
+
+					lk.unlock();
+					wal_checkpoint_result result;
+					bool failed = !ses;
+					auto start = std::chrono::steady_clock::now();
+					if (!failed)
+					{
+						try
+						{
+							ensure_attached(ses, attached, dbname, filename);
+							ses.busy_timeout(busy_timeout);
+							result = ses.wal_checkpoint(mode, dbname.c_str());
+						}
+						catch (...)
+						{
+							failed = true;
+						}
+					}
+					auto elapsed = std::chrono::steady_clock::now() - start;
+					lk.lock();
+
+					// map nodes are stable and never erased, item is still valid
+					auto & stats = state.stats;
+					if (failed) { ++stats.errors; continue; }
+
+					switch (mode)
+					{
+						case SQLITE_CHECKPOINT_PASSIVE:  ++stats.passive;  break;
+						case SQLITE_CHECKPOINT_RESTART:  ++stats.restart;  break;
+						case SQLITE_CHECKPOINT_TRUNCATE: ++stats.truncate; break;
+					}
+
+					if (result.busy) ++stats.busy;
+					if (result.checkpointed_frames > 0) stats.frames_checkpointed += result.checkpointed_frames;
+					stats.time += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+				}
+			}
+		}
+
+		bool has_pending() const noexcept
+		{
+			for (auto & item : dbs)
+				if (item.second.pending >= 0) return true;
+
+			return false;
+		}
+
+	public:
+		checkpoint_scheduler(const checkpoint_scheduler &) = delete;
+		checkpoint_scheduler & operator =(const checkpoint_scheduler &) = delete;
+
+		explicit checkpoint_scheduler(session & writer_, const checkpoint_policy & policy = {})
+			: writer(&writer_), default_policy(policy)
+		{
+			const char * filename = writer->filename("main");
+			if (!filename || !*filename)
+				throw std::invalid_argument("checkpoint_scheduler: session database is not a file");
+
+			thread = std::thread(&checkpoint_scheduler::thread_proc, this, std::string(filename));
+			writer->wal_hook(&checkpoint_scheduler::on_wal, this);
+		}
+
+		~checkpoint_scheduler() noexcept
+		{
+			writer->wal_hook<checkpoint_scheduler>(nullptr, nullptr);
+			sqlite3_wal_autocheckpoint(writer->native(), 1000);
+
+			{
+				std::lock_guard<std::mutex> lk(mutex);
+				stopping = true;
+			}
+
+			cond.notify_one();
+			thread.join();
+		}
+
+		/// sets policy for database dbname("main" or attached name)
+		void set_policy(const std::string & dbname, const checkpoint_policy & policy)
+		{
+			std::lock_guard<std::mutex> lk(mutex);
+			auto & state = dbs[dbname];
+			state.policy = policy;
+			state.has_policy = true;
+		}
+
+		/// requests checkpoint of dbname with given mode, runs on background thread
+		void request(const std::string & dbname = "main", int mode = SQLITE_CHECKPOINT_PASSIVE)
+		{
+			std::string filename;
+			if (dbname != "main")
+			{
+				const char * fname = writer->filename(dbname.c_str());
+				filename = fname ? fname : "";
+			}
+
+			{
+				std::lock_guard<std::mutex> lk(mutex);
+				auto & state = dbs[dbname];
+				if (state.filename.empty()) state.filename = std::move(filename);
+				if (mode > state.pending) state.pending = mode;
+			}
+
+			cond.notify_one();
+		}
+
+		checkpoint_stats stats(const std::string & dbname = "main") const
+		{
+			std::lock_guard<std::mutex> lk(mutex);
+			auto it = dbs.find(dbname);
+			return it == dbs.end() ? checkpoint_stats() : it->second.stats;
+		}
+	};
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sqlite3yaw/sqlite3inc.h>
+#include <sqlite3yaw/statement.hpp>
+#include <sqlite3yaw/typed_query.hpp>
+
+namespace sqlite3yaw
+{
+	/// one column of column_batch: contiguous values of single type plus validity bitmap.
+	/// layout follows Apache Arrow: fixed width values for INTEGER(int64)/FLOAT(double),
+	/// offsets(rows + 1) into bytes for TEXT/BLOB, validity bit per row(1 - not null, least significant bit first).
+	/// null rows have 0/empty value
+	struct batch_column
+	{
+		std::string name;
+		/// SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB, 0 - not yet known(all values so far are NULL).
+		/// determined by declared type of column, for expressions, untyped and NUMERIC columns - by first non null value.
+		/// can be set between fetches to force type, values are converted by sqlite rules.
+		/// INTEGER column is promoted to FLOAT when REAL value is fetched(NUMERIC columns, expressions), ints are moved to doubles
+		int type = 0;
+
+		std::vector<sqlite3_int64> ints;         /// SQLITE_INTEGER
+		std::vector<double> doubles;             /// SQLITE_FLOAT
+		std::vector<std::int32_t> offsets;       /// SQLITE_TEXT/SQLITE_BLOB, value of row i is bytes[offsets[i], offsets[i + 1])
+		std::vector<char> bytes;
+		std::vector<std::uint8_t> validity;
+		std::size_t null_count = 0;
+
+		bool is_null(std::size_t row) const noexcept { return !(validity[row / 8] & (1u << (row % 8))); }
+
+		std::string_view text(std::size_t row) const noexcept
+		{
+			return {bytes.data() + offsets[row], static_cast<std::size_t>(offsets[row + 1] - offsets[row])};
+		}
+	};
+
+	/// batch of rows stored by columns, see fetch_batch.
+	/// buffers are kept between batches: after first few batches fetching allocates nothing
+	class column_batch
+	{
+		friend std::size_t fetch_batch(statement & stmt, column_batch & batch, std::size_t n);
+
+		std::vector<batch_column> cols;
+		std::size_t rows = 0;
+		bool finished = false;   // statement is done, stepping it again would restart it
+
+	public:
+		std::size_t size() const noexcept { return rows; }
+		bool empty() const noexcept { return rows == 0; }
+		/// last fetch_batch reached end of statement
+		bool done() const noexcept { return finished; }
+		std::size_t column_count() const noexcept { return cols.size(); }
+
+		const batch_column & operator[](std::size_t idx) const noexcept { return cols[idx]; }
+		      batch_column & operator[](std::size_t idx)       noexcept { return cols[idx]; }
+
+		/// removes rows, keeps columns, their types and buffers
+		void clear() noexcept
+		{
+			rows = 0;
+			for (auto & col : cols)
+			{
+				col.ints.clear();
+				col.doubles.clear();
+				col.offsets.clear();
+				col.bytes.clear();
+				col.validity.clear();
+				col.null_count = 0;
+			}
+		}
+
+		/// forgets columns and done state, next fetch_batch determines columns from statement again.
+		/// call when statement is reset or batch is used with other statement
+		void reset() noexcept { rows = 0; finished = false; cols.clear(); }
+	};
+
+	namespace detail
+	{
+		inline int batch_column_type(statement & stmt, int idx)
+		{
+			auto * decl = stmt.column_decltype(idx);
+			if (!decl || !*decl) return 0;
+
+			switch (int affinity = decltype_affinity(decl))
+			{
+				case SQLITE_INTEGER:
+				case SQLITE_FLOAT:
+				case SQLITE_TEXT:
+					return affinity;
+				default: // BLOB affinity is also given to untyped columns, NUMERIC can hold both integers and floats
+					return 0;
+			}
+		}
+
+		/// appends default values for rows [0, rows) of column whose type just became known
+		inline void batch_backfill(batch_column & col, std::size_t rows)
+		{
+			switch (col.type)
+			{
+				case SQLITE_INTEGER: col.ints.assign(rows, 0);    break;
+				case SQLITE_FLOAT:   col.doubles.assign(rows, 0); break;
+				default:             col.offsets.assign(rows + 1, 0); break;
+			}
+		}
+
+		/// holds connection mutex(no-op for connections without mutex)
+		class db_mutex_lock
+		{
+			sqlite3_mutex * mutex;
+
+		public:
+			db_mutex_lock(const db_mutex_lock &) = delete;
+			db_mutex_lock & operator =(const db_mutex_lock &) = delete;
+
+			explicit db_mutex_lock(sqlite3 * db) noexcept : mutex(sqlite3_db_mutex(db)) { sqlite3_mutex_enter(mutex); }
+			~db_mutex_lock() noexcept { sqlite3_mutex_leave(mutex); }
+		};
+
+		/// INTEGER column got REAL value: converts fetched values to doubles instead of truncating REAL ones
+		inline void batch_promote_float(batch_column & col)
+		{
+			col.doubles.assign(col.ints.begin(), col.ints.end());
+			col.ints.clear();
+			col.type = SQLITE_FLOAT;
+		}
+
+		inline void batch_append_bytes(batch_column & col, const void * data, int size)
+		{
+			const char * ptr = static_cast<const char *>(data);
+			if (col.bytes.size() + size > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+				throw std::length_error("column_batch: text/blob column '" + col.name + "' exceeds 2GB, fetch smaller batches");
+
+			col.bytes.insert(col.bytes.end(), ptr, ptr + size);
+			col.offsets.push_back(static_cast<std::int32_t>(col.bytes.size()));
+		}
+	}
+
+	/// steps stmt up to n times, stores fetched rows into batch by columns, previous batch content is replaced.
+	/// returns number of fetched rows, less than n - statement is done, further calls return 0 until batch.reset().
+	/// on first call(or after reset) batch takes column names and types from statement.
+	///
+	/// usage: column_batch batch; while (fetch_batch(stmt, batch, 4096)) sum += std::accumulate(batch[0].doubles...);
+	inline std::size_t fetch_batch(statement & stmt, column_batch & batch, std::size_t n)
+	{
+		int count = stmt.column_count();
+		if (batch.cols.size() != static_cast<std::size_t>(count))
+		{
+			batch.cols.assign(count, batch_column());
+			for (int idx = 0; idx < count; ++idx)
+			{
+				batch.cols[idx].name = stmt.column_name(idx);
+				batch.cols[idx].type = detail::batch_column_type(stmt, idx);
+			}
+		}
+
+		batch.clear();
+		if (batch.finished) return 0;
+
+		for (auto & col : batch.cols)
+		{
+			col.validity.reserve((n + 7) / 8);
+			switch (col.type)
+			{
+				case SQLITE_INTEGER: col.ints.reserve(n);    break;
+				case SQLITE_FLOAT:   col.doubles.reserve(n); break;
+				case SQLITE_TEXT:
+				case SQLITE_BLOB:    col.offsets.reserve(n + 1); col.offsets.push_back(0); break;
+			}
+		}
+
+		// values are read through sqlite3_column_value: sqlite3_column_* calls take connection mutex each,
+		// which costs more than reading value itself. mutex is held for whole batch instead,
+		// so values can't be changed by other threads while they are read
+		auto * native = stmt.native();
+		detail::db_mutex_lock lock(sqlite3_db_handle(native));
+
+		std::size_t row = 0;
+		for (; row < n && stmt.step(); ++row)
+		{
+			std::uint8_t bit = static_cast<std::uint8_t>(1u << (row % 8));
+			bool new_byte = row % 8 == 0;
+
+			for (int idx = 0; idx < count; ++idx)
+			{
+				auto & col = batch.cols[idx];
+				if (new_byte) col.validity.push_back(0);
+
+				auto * value = sqlite3_column_value(native, idx);
+				int type = sqlite3_value_type(value);
+				if (type == SQLITE_NULL)
+				{
+					++col.null_count;
+					switch (col.type)
+					{
+						case SQLITE_INTEGER: col.ints.push_back(0);    break;
+						case SQLITE_FLOAT:   col.doubles.push_back(0); break;
+						case SQLITE_TEXT:
+						case SQLITE_BLOB:    col.offsets.push_back(col.offsets.back()); break;
+					}
+
+					continue;
+				}
+
+				if (col.type == 0)
+				{
+					col.type = type;
+					detail::batch_backfill(col, row);
+				}
+				else if (type == SQLITE_FLOAT && col.type == SQLITE_INTEGER)
+					detail::batch_promote_float(col);
+
+				col.validity.back() |= bit;
+				switch (col.type)
+				{
+					case SQLITE_INTEGER: col.ints.push_back(sqlite3_value_int64(value));    break;
+					case SQLITE_FLOAT:   col.doubles.push_back(sqlite3_value_double(value)); break;
+					case SQLITE_TEXT:
+					{
+						auto * text = sqlite3_value_text(value);
+						detail::batch_append_bytes(col, text, sqlite3_value_bytes(value));
+						break;
+					}
+					case SQLITE_BLOB:
+					{
+						auto * blob = sqlite3_value_blob(value);
+						detail::batch_append_bytes(col, blob, sqlite3_value_bytes(value));
+						break;
+					}
+				}
+			}
+		}
+
+		batch.rows = row;
+		batch.finished = row < n;
+		return row;
+	}
+}
@@ -27,4 +27,10 @@
 #if !(defined(SQLITE3YAW_TO_INT) || defined(SQLITE3YAW_TO_INT_USE_NOTHING) || \
 	defined(SQLITE3YAW_TO_INT_USE_BOOST) || defined(SQLITE3YAW_TO_INT_USE_STATIC_CAST))
 #define SQLITE3YAW_TO_INT_USE_STATIC_CAST
-#endif
\ No newline at end of file
+#endif
+
+/**
+	SQLITE3YAW_INSTRUMENTATION
+	if defined - sqlite3yaw::profiler(instrumentation.hpp) collects per statement timings and counters,
+	otherwise profiler is empty no-op class and compiles away.
+*/
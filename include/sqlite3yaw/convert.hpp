@@ -1,61 +1,147 @@
 #pragma once
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 #include <sqlite3yaw/session.hpp>
 
+#if __cplusplus > 201703L && __has_include(<span>)
+#include <span>
+#endif
+
 namespace sqlite3yaw
 {
 	namespace convert
 	{
 		//bind interface used by putters
-		//this is used to not expose idx param for put methods
+		//this is used to not expose idx param for put methods.
+		//also sets result of application-defined function(see functions.hpp), results are copied
+		//unless allowStatic is set - then copy param is honored(values outliving statement, see vtab.hpp)
 		class ibind
 		{
 			int idx;
-			statement & stmt;
+			statement * stmt;
+			sqlite3_context * ctx = nullptr;
+			bool allowStatic = false;
 
 		public:
-			ibind(statement & stmt_, int idx_) : idx(idx_), stmt(stmt_) {}
+			ibind(statement & stmt_, int idx_) : idx(idx_), stmt(&stmt_) {}
+			explicit ibind(sqlite3_context * ctx_, bool allowStatic_ = false)
+				: idx(0), stmt(nullptr), ctx(ctx_), allowStatic(allowStatic_) {}
+
+			void bind(std::nullptr_t)
+			{
+				if (ctx) sqlite3_result_null(ctx);
+				else     stmt->bind_null(idx);
+			}
+
+			void bind(int i)
+			{
+				if (ctx) sqlite3_result_int(ctx, i);
+				else     stmt->bind_int(idx, i);
+			}
+
+			void bind(sqlite3_int64 i)
+			{
+				if (ctx) sqlite3_result_int64(ctx, i);
+				else     stmt->bind_int64(idx, i);
+			}
+
+			void bind(double d)
+			{
+				if (ctx) sqlite3_result_double(ctx, d);
+				else     stmt->bind_double(idx, d);
+			}
 
-			void bind(std::nullptr_t)                               { stmt.bind_null(idx); }
-			void bind(int i)                                        { stmt.bind_int(idx, i); }
-			void bind(sqlite3_int64 i)                              { stmt.bind_int64(idx, i); }
-			void bind(double d)                                     { stmt.bind_double(idx, d); }
-			void bind(const char * str, int len, bool copy = true)  { stmt.bind_text(idx, str, len, copy); }
+			void bind(const char * str, int len, bool copy = true)
+			{
+				if (ctx) sqlite3_result_text(ctx, str, len, copy || !allowStatic ? SQLITE_TRANSIENT : SQLITE_STATIC);
+				else     stmt->bind_text(idx, str, len, copy);
+			}
+
+			void bind_blob(const void * data, std::size_t size, bool copy = true)
+			{
+				if (!ctx)          stmt->bind_blob(idx, data, size, copy);
+				else if (size == 0) sqlite3_result_zeroblob(ctx, 0);
+				else                sqlite3_result_blob64(ctx, data, size, copy || !allowStatic ? SQLITE_TRANSIENT : SQLITE_STATIC);
+			}
+
+			/// see statement::bind_pointer
+			void bind_pointer(void * ptr, const char * type, void (* destroy)(void *))
+			{
+				if (ctx) sqlite3_result_pointer(ctx, ptr, type, destroy);
+				else     stmt->bind_pointer(idx, ptr, type, destroy);
+			}
 			
 			//see also statement::bind_text
 			template <class String>
 			void bind(String const & str, bool copy = true)
 			{
-				stmt.bind_text(idx, str, copy);
+				bind(str.data(), ToInt(str.size()), copy);
 			}
 		};
 
 		//query interface used by getters
-		//this is used to not expose idx param for get methods
+		//this is used to not expose idx param for get methods.
+		//also reads arguments of application-defined function(see functions.hpp)
 		class iquery
 		{
 			int idx;
-			statement & stmt;
+			statement * stmt;
+			sqlite3_value * value = nullptr;
 
 		public:
-			iquery(statement & stmt_, int idx_) : idx(idx_), stmt(stmt_) {}
+			iquery(statement & stmt_, int idx_) : idx(idx_), stmt(&stmt_) {}
+			explicit iquery(sqlite3_value * value_) : idx(0), stmt(nullptr), value(value_) {}
+
+			int  get_type()                    { return value ? sqlite3_value_type(value)   : stmt->column_type(idx); }
+			int  get_int()                     { return value ? sqlite3_value_int(value)    : stmt->column_int(idx); }
+			sqlite3_int64  get_int64()         { return value ? sqlite3_value_int64(value)  : stmt->column_int64(idx); }
+			double  get_double()               { return value ? sqlite3_value_double(value) : stmt->column_double(idx); }
+			int  get_bytes()                   { return value ? sqlite3_value_bytes(value)  : stmt->column_bytes(idx); }
+			const void * get_blob()            { return value ? sqlite3_value_blob(value)   : stmt->column_blob(idx); }
 
-			int  get_type()                    { return stmt.column_type(idx); }
-			int  get_int()                     { return stmt.column_int(idx); }
-			sqlite3_int64  get_int64()         { return stmt.column_int64(idx); }
-			double  get_double()               { return stmt.column_double(idx); }
-			const char * get_text()            { return stmt.column_text(idx); }
-			int  get_bytes()                   { return stmt.column_bytes(idx); }
+			const char * get_text()
+			{
+				return value ? reinterpret_cast<const char *>(sqlite3_value_text(value)) : stmt->column_text(idx);
+			}
+
+			std::string_view get_string_view()
+			{
+				if (!value) return stmt->column_string_view(idx);
+
+				auto text = get_text();
+				auto sz = get_bytes();
+				return text ? std::string_view(text, sz) : std::string_view();
+			}
 
 			template <class String>
 			void get_string(String & str)
 			{
-				stmt.column_string(idx, str);
+				if (!value) return stmt->column_string(idx, str);
+
+				auto text = get_text();
+				auto sz = get_bytes();
+				str.assign(text, text + sz);
 			}
 		};
 
 		template <class Type>
 		struct conv;
 
+		/// non owning view types: bind copies them only when forceCopy is requested, not when they are rvalues -
+		/// temporary view of living data is common: bind(stmt, 1, std::string_view(str))
+		template <class Type>
+		struct is_view : std::false_type {};
+
+		template <class traits>
+		struct is_view<std::basic_string_view<char, traits>> : std::true_type {};
+
+#if __cplusplus > 201703L && __has_include(<span>)
+		template <class Elem, std::size_t Extent>
+		struct is_view<std::span<Elem, Extent>> : std::true_type {};
+#endif
+
 		template <>
 		struct conv<int>
 		{
@@ -93,6 +179,50 @@ namespace sqlite3yaw
 			static void get(string & val, iquery & q) { q.get_string(val); }
 		};
 
+		/// string_view is bound with SQLITE_STATIC unless copy is forced, referenced data must live until statement is reset or rebound.
+		/// getted view points into statement and is valid until next step/reset/finalize
+		template <class traits>
+		struct conv<std::basic_string_view<char, traits>>
+		{
+			typedef std::basic_string_view<char, traits> string_view;
+			static void put(string_view val, bool temp, ibind & b) { b.bind(val.empty() ? "" : val.data(), ToInt(val.size()), temp); }
+			static void get(string_view & val, iquery & q)
+			{
+				auto sv = q.get_string_view();
+				val = string_view(sv.data(), sv.size());
+			}
+		};
+
+		template <class allocator>
+		struct conv<std::vector<std::byte, allocator>>
+		{
+			typedef std::vector<std::byte, allocator> blob;
+			static void put(blob const & val, bool temp, ibind & b) { b.bind_blob(val.data(), val.size(), temp); }
+			static void get(blob & val, iquery & q)
+			{
+				auto * data = static_cast<const std::byte *>(q.get_blob());
+				auto sz = q.get_bytes();
+				val.assign(data, data + sz);
+			}
+		};
+
+#if __cplusplus > 201703L && __has_include(<span>)
+		/// span is bound with SQLITE_STATIC unless copy is forced, referenced data must live until statement is reset or rebound.
+		/// getted span points into statement and is valid until next step/reset/finalize
+		template <>
+		struct conv<std::span<const std::byte>>
+		{
+			typedef std::span<const std::byte> span;
+			static void put(span val, bool temp, ibind & b) { b.bind_blob(val.data(), val.size(), temp); }
+			static void get(span & val, iquery & q)
+			{
+				auto * data = static_cast<const std::byte *>(q.get_blob());
+				auto sz = q.get_bytes();
+				val = span(data, sz);
+			}
+		};
+#endif
+
 		template <>
 		struct conv<std::nullptr_t>
 		{
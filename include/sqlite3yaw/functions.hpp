@@ -0,0 +1,341 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <sqlite3yaw/sqlite3inc.h>
+#include <sqlite3yaw/exceptions.hpp>
+#include <sqlite3yaw/session.hpp>
+#include <sqlite3yaw/convert.hpp>
+
+namespace sqlite3yaw
+{
+	/// arguments of variadic application-defined function, callable taking function_args is registered with any number of arguments.
+	/// values are valid during function call
+	class function_args
+	{
+		int argc;
+		sqlite3_value ** argv;
+
+	public:
+		function_args(int argc_, sqlite3_value ** argv_) noexcept : argc(argc_), argv(argv_) {}
+
+		int size() const noexcept { return argc; }
+		sqlite3_value * native(int idx) const noexcept { return argv[idx]; }
+
+		int  type(int idx) const noexcept    { return sqlite3_value_type(argv[idx]); }
+		bool is_null(int idx) const noexcept { return type(idx) == SQLITE_NULL; }
+
+		template <class Type>
+		void get(int idx, Type & val) const
+		{
+			convert::iquery q(argv[idx]);
+			convert::conv<Type>::get(val, q);
+		}
+
+		template <class Type>
+		Type get(int idx) const
+		{
+			Type val;
+			get(idx, val);
+			return val;
+		}
+	};
+
+	namespace detail
+	{
+		/// result and decayed argument types of callable: function, function pointer, functor with non template operator()
+		template <class Func>
+		struct callable_traits : callable_traits<decltype(&Func::operator())> {};
+
+		template <class Ret, class ... Args>
+		struct callable_traits<Ret(Args...)>
+		{
+			typedef Ret result_type;
+			typedef std::tuple<std::decay_t<Args>...> args_type;
+			static constexpr std::size_t arity = sizeof...(Args);
+		};
+
+		template <class Ret, class ... Args>
+		struct callable_traits<Ret(Args...) noexcept> : callable_traits<Ret(Args...)> {};
+
+		template <class Ret, class ... Args>
+		struct callable_traits<Ret(*)(Args...)> : callable_traits<Ret(Args...)> {};
+
+		template <class Ret, class ... Args>
+		struct callable_traits<Ret(*)(Args...) noexcept> : callable_traits<Ret(Args...)> {};
+
+		template <class Class, class Ret, class ... Args>
+		struct callable_traits<Ret(Class::*)(Args...)> : callable_traits<Ret(Args...)> {};
+
+		template <class Class, class Ret, class ... Args>
+		struct callable_traits<Ret(Class::*)(Args...) const> : callable_traits<Ret(Args...)> {};
+
+		template <class Class, class Ret, class ... Args>
+		struct callable_traits<Ret(Class::*)(Args...) noexcept> : callable_traits<Ret(Args...)> {};
+
+		template <class Class, class Ret, class ... Args>
+		struct callable_traits<Ret(Class::*)(Args...) const noexcept> : callable_traits<Ret(Args...)> {};
+
+		template <class ArgsTuple>
+		struct is_variadic_args : std::false_type {};
+
+		template <>
+		struct is_variadic_args<std::tuple<function_args>> : std::true_type {};
+
+		/// number of arguments for sqlite3_create_function_v2, -1 - any
+		template <class ArgsTuple>
+		constexpr int function_arity()
+		{
+			return is_variadic_args<ArgsTuple>::value ? -1 : static_cast<int>(std::tuple_size<ArgsTuple>::value);
+		}
+
+		template <class Type>
+		Type function_arg(sqlite3_value * value)
+		{
+			// if you get here undefined type conv<Type>
+			// then your type conversion is not registered. see convert.hpp
+			convert::iquery q(value);
+			Type val;
+			convert::conv<Type>::get(val, q);
+			return val;
+		}
+
+		template <class Type>
+		void set_result(sqlite3_context * ctx, const Type & val)
+		{
+			convert::ibind b(ctx);
+			convert::conv<std::decay_t<Type>>::put(val, true, b);
+		}
+
+		/// calls func with arguments decoded from argv by conv<Args>, sets result by conv<Ret>, void result - NULL
+		template <class ArgsTuple, class Func, std::size_t ... Is>
+		void invoke_function(Func && func, sqlite3_context * ctx, int argc, sqlite3_value ** argv, std::index_sequence<Is...>)
+		{
+			typedef decltype(func(std::declval<std::tuple_element_t<Is, ArgsTuple>>()...)) Ret;
+			if constexpr (is_variadic_args<ArgsTuple>::value)
+			{
+				if constexpr (std::is_void<Ret>::value)
+					func(function_args(argc, argv)), sqlite3_result_null(ctx);
+				else
+					set_result(ctx, func(function_args(argc, argv)));
+			}
+			else
+			{
+				(void)argc; (void)argv;
+				if constexpr (std::is_void<Ret>::value)
+					func(function_arg<std::tuple_element_t<Is, ArgsTuple>>(argv[Is])...), sqlite3_result_null(ctx);
+				else
+					set_result(ctx, func(function_arg<std::tuple_element_t<Is, ArgsTuple>>(argv[Is])...));
+			}
+		}
+
+		/// exceptions can't cross sqlite C frames, they are reported as function error
+		template <class Functor>
+		void call_guarded(sqlite3_context * ctx, Functor && func) noexcept
+		{
+			try
+			{
+				func();
+			}
+			catch (std::bad_alloc &)
+			{
+				sqlite3_result_error_nomem(ctx);
+			}
+			catch (sqlite_error & ex)
+			{
+				sqlite3_result_error(ctx, ex.what(), -1);
+				sqlite3_result_error_code(ctx, ex.code().value());
+			}
+			catch (std::exception & ex)
+			{
+				sqlite3_result_error(ctx, ex.what(), -1);
+			}
+			catch (...)
+			{
+				sqlite3_result_error(ctx, "unknown exception in application-defined function", -1);
+			}
+		}
+
+		template <class Type>
+		void destroy_user_data(void * ptr) noexcept
+		{
+			delete static_cast<Type *>(ptr);
+		}
+
+		template <class Func>
+		struct scalar_function
+		{
+			typedef typename callable_traits<Func>::args_type args_type;
+			typedef std::make_index_sequence<std::tuple_size<args_type>::value> indexes;
+
+			static void call(sqlite3_context * ctx, int argc, sqlite3_value ** argv) noexcept
+			{
+				auto & func = *static_cast<Func *>(sqlite3_user_data(ctx));
+				call_guarded(ctx, [&] { invoke_function<args_type>(func, ctx, argc, argv, indexes()); });
+			}
+		};
+
+		/// per group state of aggregate, lives in sqlite3_aggregate_context memory(zero initialized, 8 byte aligned),
+		/// over aligned states are allocated on heap
+		template <class State, bool inplace = alignof(State) <= 8>
+		struct aggregate_slot
+		{
+			State * state;   // null until first step
+			typename std::aligned_storage<sizeof(State), alignof(State)>::type storage;
+
+			State * construct(const State & proto) { return state = new (&storage) State(proto); }
+			void destroy() noexcept { if (state) state->~State(); state = nullptr; }
+		};
+
+		template <class State>
+		struct aggregate_slot<State, false>
+		{
+			State * state;
+
+			State * construct(const State & proto) { return state = new State(proto); }
+			void destroy() noexcept { delete state; state = nullptr; }
+		};
+
+		template <class State>
+		struct aggregate_function
+		{
+			typedef aggregate_slot<State> slot_type;
+			typedef typename callable_traits<decltype(&State::step)>::args_type args_type;
+			typedef std::make_index_sequence<std::tuple_size<args_type>::value> indexes;
+
+			static const State & prototype(sqlite3_context * ctx) noexcept
+			{
+				return *static_cast<const State *>(sqlite3_user_data(ctx));
+			}
+
+			static State & state(sqlite3_context * ctx)
+			{
+				auto * slot = static_cast<slot_type *>(sqlite3_aggregate_context(ctx, sizeof(slot_type)));
+				if (!slot) throw std::bad_alloc();
+				return slot->state ? *slot->state : *slot->construct(prototype(ctx));
+			}
+
+			static void step(sqlite3_context * ctx, int argc, sqlite3_value ** argv) noexcept
+			{
+				call_guarded(ctx, [&]
+				{
+					auto & st = state(ctx);
+					invoke_function<args_type>([&st](auto && ... args) { st.step(std::forward<decltype(args)>(args)...); },
+						ctx, argc, argv, indexes());
+				});
+			}
+
+			static void inverse(sqlite3_context * ctx, int argc, sqlite3_value ** argv) noexcept
+			{
+				call_guarded(ctx, [&]
+				{
+					auto & st = state(ctx);
+					invoke_function<args_type>([&st](auto && ... args) { st.inverse(std::forward<decltype(args)>(args)...); },
+						ctx, argc, argv, indexes());
+				});
+			}
+
+			/// current value of window function
+			static void value(sqlite3_context * ctx) noexcept
+			{
+				call_guarded(ctx, [ctx] { set_result(ctx, state(ctx).value()); });
+			}
+
+			static void final(sqlite3_context * ctx) noexcept
+			{
+				auto * slot = static_cast<slot_type *>(sqlite3_aggregate_context(ctx, 0));
+				call_guarded(ctx, [ctx, slot]
+				{
+					if (slot && slot->state)
+						set_result(ctx, slot->state->value());
+					else // no rows in group
+						set_result(ctx, State(prototype(ctx)).value());
+				});
+
+				if (slot) slot->destroy();
+			}
+		};
+
+		inline void check_function_result(session & ses, int res)
+		{
+			if (res != SQLITE_OK)
+				throw sqlite_exterror(res, ses.native());
+		}
+	}
+
+	/// registers application-defined scalar SQL function name, implemented by callable func.
+	/// arguments are decoded with conv<std::decay_t<Arg>>, result is set with conv<Ret>, void result is NULL.
+	/// number of SQL arguments is number of func arguments, callable taking single function_args accepts any number.
+	/// NULL argument is decoded as conv<Arg> does(0, empty string) - use function_args to distinguish NULLs.
+	/// exceptions are reported as SQL errors with what() message.
+	///
+	/// flags are OR-ed with SQLITE_UTF8: SQLITE_DETERMINISTIC - same arguments give same result,
+	/// planner can evaluate function once and use it in indexes; SQLITE_INNOCUOUS(3.31+) - no side effects,
+	/// allowed in schema and triggers under trusted_schema=OFF; SQLITE_DIRECTONLY(3.30+) - only from top level SQL
+	///
+	/// usage: create_function(ses, "add", [](int a, int b) { return a + b; }, SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS);
+	template <class Func>
+	void create_function(session & ses, const char * name, Func func, int flags = 0)
+	{
+		typedef detail::scalar_function<Func> function;
+		int arity = detail::function_arity<typename function::args_type>();
+
+		// on failure sqlite calls destroy itself
+		int res = sqlite3_create_function_v2(ses.native(), name, arity, SQLITE_UTF8 | flags,
+			new Func(std::move(func)), &function::call, nullptr, nullptr, &detail::destroy_user_data<Func>);
+
+		detail::check_function_result(ses, res);
+	}
+
+	/// registers application-defined aggregate SQL function name.
+	/// State holds per group state, it must have:
+	///   step(Args...)   - called for each row of group, arguments are decoded as in create_function;
+	///   value()         - returns result of group, conv<Ret> must be defined.
+	/// state of each group is copy constructed from prototype and destroyed after value() is taken.
+	/// for empty input sqlite calls only final - value() of prototype copy is returned.
+	///
+	/// usage: struct sum_sq { double sum = 0; void step(double v) { sum += v * v; } double value() const { return sum; } };
+	///        create_aggregate(ses, "sum_sq", sum_sq(), SQLITE_DETERMINISTIC);
+	template <class State>
+	void create_aggregate(session & ses, const char * name, State prototype = State(), int flags = 0)
+	{
+		typedef detail::aggregate_function<State> function;
+		int arity = detail::function_arity<typename function::args_type>();
+
+		int res = sqlite3_create_function_v2(ses.native(), name, arity, SQLITE_UTF8 | flags,
+			new State(std::move(prototype)), nullptr, &function::step, &function::final, &detail::destroy_user_data<State>);
+
+		detail::check_function_result(ses, res);
+	}
+
+#if SQLITE_VERSION_NUMBER >= 3025000
+	/// registers aggregate window function name(sqlite 3.25+), can be used both as aggregate and with OVER clause.
+	/// in addition to create_aggregate requirements State must have:
+	///   inverse(Args...) - removes row, previously passed to step, from window;
+	///   value()          - called repeatedly for current window, must not reset state.
+	template <class State>
+	void create_window_function(session & ses, const char * name, State prototype = State(), int flags = 0)
+	{
+		typedef detail::aggregate_function<State> function;
+		int arity = detail::function_arity<typename function::args_type>();
+
+		int res = sqlite3_create_window_function(ses.native(), name, arity, SQLITE_UTF8 | flags,
+			new State(std::move(prototype)), &function::step, &function::final, &function::value, &function::inverse,
+			&detail::destroy_user_data<State>);
+
+		detail::check_function_result(ses, res);
+	}
+#endif
+
+	/// removes application-defined function name with given number of arguments(-1 - variadic one)
+	inline void remove_function(session & ses, const char * name, int arity)
+	{
+		int res = sqlite3_create_function_v2(ses.native(), name, arity, SQLITE_UTF8, nullptr, nullptr, nullptr, nullptr, nullptr);
+		detail::check_function_result(ses, res);
+	}
+}
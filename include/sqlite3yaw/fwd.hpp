@@ -9,4 +9,10 @@ namespace sqlite3yaw
 
 	class session;
 	class statement;
+	class statement_cache;
+	class cached_statement;
+	class change_feed;
+	class profiler;
+	class backup;
+	class checkpoint_scheduler;
 }
\ No newline at end of file
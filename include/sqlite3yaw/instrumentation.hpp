@@ -0,0 +1,370 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sqlite3yaw/config.hpp>
+#include <sqlite3yaw/session.hpp>
+
+namespace sqlite3yaw
+{
+	/// log-linear latency histogram, HDR-like: each power of 2 range is split into 16 buckets,
+	/// so relative error of recorded value is below 1/16. values are nanoseconds, whole uint64 range is covered
+	class latency_histogram
+	{
+	public:
+		static constexpr unsigned sub_bits = 4;
+		static constexpr unsigned sub_count = 1u << sub_bits;
+		static constexpr unsigned bucket_count = (64 - sub_bits + 1) * sub_count;
+
+	private:
+		std::array<std::uint64_t, bucket_count> buckets = {};
+		std::uint64_t total = 0;
+		std::uint64_t sum_ = 0;
+		std::uint64_t min_ = UINT64_MAX;
+		std::uint64_t max_ = 0;
+
+	private:
+		static unsigned floor_log2(std::uint64_t val) noexcept
+		{
+			unsigned ret = 0;
+			for (unsigned shift = 32; shift; shift >>= 1)
+				if (val >> shift) val >>= shift, ret += shift;
+
+			return ret;
+		}
+
+	public:
+		static unsigned bucket_index(std::uint64_t val) noexcept
+		{
+			if (val < sub_count) return static_cast<unsigned>(val);
+
+			unsigned exp = floor_log2(val);
+			unsigned sub = static_cast<unsigned>(val >> (exp - sub_bits)) & (sub_count - 1);
+			return (exp - sub_bits + 1) * sub_count + sub;
+		}
+
+		/// smallest value falling into bucket idx
+		static std::uint64_t bucket_lower(unsigned idx) noexcept
+		{
+			if (idx < sub_count) return idx;
+
+			unsigned exp = idx / sub_count + sub_bits - 1;
+			std::uint64_t sub = idx % sub_count;
+			return (sub_count + sub) << (exp - sub_bits);
+		}
+
+		void record(std::uint64_t val) noexcept
+		{
+			++buckets[bucket_index(val)];
+			++total;
+			sum_ += val;
+			min_ = std::min(min_, val);
+			max_ = std::max(max_, val);
+		}
+
+		void merge(const latency_histogram & other) noexcept
+		{
+			for (unsigned i = 0; i < bucket_count; ++i)
+				buckets[i] += other.buckets[i];
+
+			total += other.total;
+			sum_ += other.sum_;
+			min_ = std::min(min_, other.min_);
+			max_ = std::max(max_, other.max_);
+		}
+
+		std::uint64_t count() const noexcept { return total; }
+		std::uint64_t sum() const noexcept   { return sum_; }
+		std::uint64_t min() const noexcept   { return total ? min_ : 0; }
+		std::uint64_t max() const noexcept   { return max_; }
+		double mean() const noexcept         { return total ? static_cast<double>(sum_) / total : 0; }
+		std::uint64_t bucket(unsigned idx) const noexcept { return buckets[idx]; }
+
+		/// value at given percentile(0 - 100), upper bound of bucket holding it clamped by max
+		std::uint64_t percentile(double pct) const noexcept
+		{
+			if (!total) return 0;
+
+			auto rank = static_cast<std::uint64_t>(pct / 100 * total + 0.5);
+			rank = std::max<std::uint64_t>(1, std::min(rank, total));
+
+			std::uint64_t seen = 0;
+			for (unsigned i = 0; i < bucket_count; ++i)
+			{
+				seen += buckets[i];
+				if (seen >= rank)
+					return i + 1 < bucket_count ? std::min(max_, bucket_lower(i + 1) - 1) : max_;
+			}
+
+			return max_;
+		}
+	};
+
+	/// accumulated profile of statements with same normalized sql
+	struct statement_profile
+	{
+		std::string sql;                      /// normalized sql, see normalize_sql
+		latency_histogram latency;            /// execution time in nanoseconds, as reported by SQLITE_TRACE_PROFILE
+		std::uint64_t fullscan_steps = 0;     /// SQLITE_STMTSTATUS_FULLSCAN_STEP
+		std::uint64_t sorts = 0;              /// SQLITE_STMTSTATUS_SORT
+		std::uint64_t autoindexes = 0;        /// SQLITE_STMTSTATUS_AUTOINDEX
+		std::uint64_t vm_steps = 0;           /// SQLITE_STMTSTATUS_VM_STEP
+		std::uint64_t reprepares = 0;         /// SQLITE_STMTSTATUS_REPREPARE
+	};
+
+	/// normalizes sql text for grouping: literals are replaced with ?, comments are removed,
+	/// whitespace runs are collapsed into one space. identifiers and keywords are kept as is
+	inline void normalize_sql(const char * sql, std::string & out)
+	{
+		auto is_ident = [](char ch) { return ch == '_' || ch == '$' || (ch >= '0' && ch <= '9') ||
+		                              (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch & 0x80); };
+		auto is_digit = [](char ch) { return ch >= '0' && ch <= '9'; };
+		auto skip_quoted = [](const char * p, char close)
+		{
+			for (++p; *p; ++p)
+			{
+				if (*p != close) continue;
+				if (p[1] != close) return p + 1;
+				++p; // doubled quote
+			}
+			return p;
+		};
+
+		out.clear();
+		bool space = false;
+		const char * p = sql;
+		while (*p)
+		{
+			char ch = *p;
+			if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f')
+			{
+				space = true, ++p;
+				continue;
+			}
+
+			if (ch == '-' && p[1] == '-')
+			{
+				while (*p && *p != '\n') ++p;
+				space = true;
+				continue;
+			}
+
+			if (ch == '/' && p[1] == '*')
+			{
+				for (p += 2; *p && !(*p == '*' && p[1] == '/'); ++p) continue;
+				if (*p) p += 2;
+				space = true;
+				continue;
+			}
+
+			if (space && !out.empty()) out += ' ';
+			space = false;
+
+			if (ch == '\'' || ((ch == 'x' || ch == 'X') && p[1] == '\'' && (out.empty() || !is_ident(out.back()))))
+			{
+				p = skip_quoted(ch == '\'' ? p : p + 1, '\'');
+				out += '?';
+			}
+			else if (ch == '"' || ch == '`')
+			{
+				const char * first = p;
+				p = skip_quoted(p, ch);
+				out.append(first, p);
+			}
+			else if (ch == '[')
+			{
+				const char * first = p;
+				while (*p && *p != ']') ++p;
+				if (*p) ++p;
+				out.append(first, p);
+			}
+			else if ((is_digit(ch) || (ch == '.' && is_digit(p[1]))) && (out.empty() || !is_ident(out.back())))
+			{
+				if (ch == '0' && (p[1] == 'x' || p[1] == 'X'))
+					for (p += 2; is_ident(*p); ++p) continue;
+				else
+				{
+					while (is_digit(*p) || *p == '.') ++p;
+					if ((*p == 'e' || *p == 'E') && (is_digit(p[1]) || ((p[1] == '+' || p[1] == '-') && is_digit(p[2]))))
+						for (p += 2; is_digit(*p); ++p) continue;
+				}
+
+				out += '?';
+			}
+			else if (is_ident(ch))
+			{
+				const char * first = p;
+				while (is_ident(*p)) ++p;
+				out.append(first, p);
+			}
+			else
+				out += ch, ++p;
+		}
+	}
+
+	inline std::string normalize_sql(const char * sql)
+	{
+		std::string ret;
+		normalize_sql(sql, ret);
+		return ret;
+	}
+
+#ifdef SQLITE3YAW_INSTRUMENTATION
+	/// collects per statement timings and VM counters of session via sqlite3_trace_v2(SQLITE_TRACE_STMT/SQLITE_TRACE_PROFILE).
+	/// execution time is measured with steady_clock from statement start to completion.
+	/// statements are grouped by normalize_sql of their text.
+	/// on each completed execution statement counters are read with reset(except reprepare, which is tracked by delta),
+	/// so sqlite3_stmt_status values seen by other code are per execution while profiler is attached.
+	///
+	/// profiler takes over trace callback of session and removes it on destruction, session must outlive profiler.
+	/// callback runs on thread using the session, snapshot/reset can be called from any thread.
+	///
+	/// without SQLITE3YAW_INSTRUMENTATION defined profiler is empty class with no-op methods,
+	/// trace callback is not registered and nothing is collected.
+	class profiler
+	{
+		session * ses;
+
+		mutable std::mutex mutex;
+		std::unordered_map<std::string, statement_profile> profiles;
+		std::string normalized; // buffer, reused
+
+		struct stmt_state
+		{
+			std::chrono::steady_clock::time_point start;
+			int reprepares = 0;   // last seen SQLITE_STMTSTATUS_REPREPARE
+		};
+
+		// touched only from trace callback. finalized statements are not reported,
+		// so map is just dropped when it grows too big
+		std::unordered_map<sqlite3_stmt *, stmt_state> states;
+
+	private:
+		static int on_trace(unsigned type, profiler * self, void * p, void * x) noexcept
+		{
+			try
+			{
+				if (type == SQLITE_TRACE_STMT)
+					self->start(static_cast<sqlite3_stmt *>(p), static_cast<const char *>(x));
+				else if (type == SQLITE_TRACE_PROFILE)
+					self->record(static_cast<sqlite3_stmt *>(p), *static_cast<sqlite3_int64 *>(x));
+			}
+			catch (...)
+			{
+				// out of memory, sample is lost
+			}
+
+			return 0;
+		}
+
+		stmt_state & state(sqlite3_stmt * stmt)
+		{
+			if (states.size() >= 4096) states.clear();
+			return states[stmt];
+		}
+
+		void start(sqlite3_stmt * stmt, const char * text)
+		{
+			// trigger subprograms are reported with "-- TRIGGER name" text and same stmt
+			if (text[0] == '-' && text[1] == '-') return;
+			state(stmt).start = std::chrono::steady_clock::now();
+		}
+
+		void record(sqlite3_stmt * stmt, sqlite3_int64 ns)
+		{
+			// sqlite measures with VFS xCurrentTimeInt64, which has millisecond resolution,
+			// use own measurement from SQLITE_TRACE_STMT if there is one
+			auto & st = state(stmt);
+			if (st.start != std::chrono::steady_clock::time_point())
+			{
+				ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - st.start).count();
+				st.start = {};
+			}
+
+			// not reset, statement::column_index relies on it
+			int repr = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_REPREPARE, 0);
+			int reprepared = repr > st.reprepares ? repr - st.reprepares : 0;
+			st.reprepares = repr;
+
+			const char * sql = sqlite3_sql(stmt);
+			normalize_sql(sql ? sql : "", normalized);
+
+			std::lock_guard<std::mutex> lk(mutex);
+			auto it = profiles.find(normalized);
+			if (it == profiles.end())
+			{
+				it = profiles.emplace(normalized, statement_profile()).first;
+				it->second.sql = normalized;
+			}
+
+			auto & prof = it->second;
+			prof.latency.record(static_cast<std::uint64_t>(ns));
+			prof.fullscan_steps += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+			prof.sorts          += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+			prof.autoindexes    += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, 1);
+			prof.vm_steps       += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+			prof.reprepares     += reprepared;
+		}
+
+	public:
+		profiler(const profiler &) = delete;
+		profiler & operator =(const profiler &) = delete;
+
+		static constexpr bool enabled = true;
+
+		explicit profiler(session & ses_) : ses(&ses_)
+		{
+			ses->trace_v2(SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE, &profiler::on_trace, this);
+		}
+
+		~profiler() noexcept
+		{
+			sqlite3_trace_v2(ses->native(), 0, nullptr, nullptr);
+		}
+
+		/// copy of collected profiles, sorted by total time descending
+		std::vector<statement_profile> snapshot() const
+		{
+			std::vector<statement_profile> ret;
+			{
+				std::lock_guard<std::mutex> lk(mutex);
+				ret.reserve(profiles.size());
+				for (auto & item : profiles)
+					ret.push_back(item.second);
+			}
+
+			std::sort(ret.begin(), ret.end(),
+				[](auto & p1, auto & p2) { return p1.latency.sum() > p2.latency.sum(); });
+			return ret;
+		}
+
+		/// drops collected profiles
+		void reset()
+		{
+			std::lock_guard<std::mutex> lk(mutex);
+			profiles.clear();
+		}
+	};
+#else
+	class profiler
+	{
+	public:
+		profiler(const profiler &) = delete;
+		profiler & operator =(const profiler &) = delete;
+
+		static constexpr bool enabled = false;
+
+		explicit profiler(session &) noexcept {}
+
+		std::vector<statement_profile> snapshot() const { return {}; }
+		void reset() noexcept {}
+	};
+#endif
+}
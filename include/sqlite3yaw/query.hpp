@@ -1,5 +1,7 @@
 #pragma once
 #include <cstring>
+#include <initializer_list>
+#include <vector>
 #include <sqlite3yaw/convert.hpp>
 
 namespace sqlite3yaw
@@ -11,13 +13,11 @@ namespace sqlite3yaw
 	};
 	
 	//returns -1 if not found
+	//see also statement::column_index
 	inline
 	int column_name_to_index(statement & stmt, const char * name)
 	{
-		for (int i = 0; i < stmt.column_count(); ++i)
-			if (std::strcmp(name, stmt.column_name(i)) == 0)
-				return i;
-		return -1;
+		return stmt.column_index(name);
 	}
 
 	//returns -1 if not found
@@ -100,6 +100,43 @@ namespace sqlite3yaw
 		void operator()(Type & val) { g(idx++, val); }
 	};
 
+	/// getter by column names, names are resolved to indexes once at construction,
+	/// values are read by position of name in construction list.
+	/// 
+	/// usage: named_getter g(stmt, {"name", "type"}); g(0, name); g(1, type);
+	/// 
+	/// if statement is reprepared by sqlite and column positions change - named_getter must be recreated
+	class named_getter
+	{
+		statement * stmt;
+		std::vector<int> indexes;
+
+	public:
+		typedef void result_type; //for bind, ref, cref compability
+
+		/// throws no_such_column if some name is not found
+		named_getter(statement & stmt_, std::initializer_list<const char *> names)
+			: stmt(&stmt_)
+		{
+			indexes.reserve(names.size());
+			for (auto * name : names)
+			{
+				int idx = stmt->column_index(name);
+				if (idx == -1) throw no_such_column(name);
+				indexes.push_back(idx);
+			}
+		}
+
+		/// column index of n-th name
+		int index(std::size_t n) const { return indexes[n]; }
+
+		template <class Type>
+		void operator()(std::size_t n, Type & val) const
+		{
+			get(*stmt, indexes[n], val);
+		}
+	};
+
 	template <class Type>
 	class getgen
 	{
@@ -0,0 +1,136 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <sqlite3yaw/record_traits.hpp>
+#include <sqlite3yaw/bind.hpp>
+#include <sqlite3yaw/query.hpp>
+
+namespace sqlite3yaw
+{
+	/// binds whole Record, described by record_traits<Record>, to statement.
+	/// parameter index of each column is resolved once, at construction:
+	/// by name - :name, @name or $name, members without such parameter are not bound.
+	/// if statement has no named parameters for any column and exactly as many parameters as columns -
+	/// columns are bound by position, in record_traits order, other parameter count is std::invalid_argument.
+	///
+	/// usage: record_binder<person> b(stmt); for (auto & p : persons) { b(p); stmt.step(); stmt.reset(); }
+	template <class Record>
+	class record_binder
+	{
+		static constexpr std::size_t column_count = record_column_count<Record>;
+
+		statement * stmt;
+		std::array<int, column_count> indexes;   // 0 - not bound
+		bool forceCopy;
+
+	public:
+		typedef void result_type; //for bind, ref, cref compability
+
+		explicit record_binder(statement & stmt_, bool forceCopy_ = false)
+			: stmt(&stmt_), forceCopy(forceCopy_)
+		{
+			bool named = false;
+			std::string pname;
+			for_each_column<Record>([this, &named, &pname](std::size_t n, const auto & col)
+			{
+				int idx = 0;
+				for (char prefix : {':', '@', '$'})
+				{
+					pname = prefix;
+					pname += col.name;
+					if ((idx = stmt->bind_parameter_index(pname)) != 0) break;
+				}
+
+				indexes[n] = idx;
+				named |= idx != 0;
+			});
+
+			if (named) return;
+
+			int count = stmt->bind_parameter_count();
+			if (count != static_cast<int>(column_count))
+				throw std::invalid_argument("record_binder: statement has no named parameters for record columns and " +
+				                            std::to_string(count) + " parameters, record has " + std::to_string(column_count) + " columns");
+
+			for (std::size_t n = 0; n < column_count; ++n)
+				indexes[n] = static_cast<int>(n + 1);
+		}
+
+		/// parameter index of n-th column, 0 if it's not bound
+		int index(std::size_t n) const { return indexes[n]; }
+
+		void operator()(const Record & rec) const
+		{
+			for_each_column<Record>([this, &rec](std::size_t n, const auto & col)
+			{
+				if (indexes[n]) bind(*stmt, indexes[n], rec.*col.member, forceCopy);
+			});
+		}
+	};
+
+	/// reads current row of statement into Record, described by record_traits<Record>.
+	/// column index of each member is resolved once, at construction, by statement::column_index(case sensitive).
+	/// if required - missing column is error(no_such_column), otherwise such member is left untouched.
+	///
+	/// if statement is reprepared by sqlite and column positions change - record_getter must be recreated
+	template <class Record>
+	class record_getter
+	{
+		static constexpr std::size_t column_count = record_column_count<Record>;
+
+		statement * stmt;
+		std::array<int, column_count> indexes;   // -1 - not present
+
+	public:
+		explicit record_getter(statement & stmt_, bool required = true)
+			: stmt(&stmt_)
+		{
+			for_each_column<Record>([this, required](std::size_t n, const auto & col)
+			{
+				indexes[n] = stmt->column_index(col.name);
+				if (indexes[n] == -1 && required)
+					throw no_such_column(col.name);
+			});
+		}
+
+		/// column index of n-th member, -1 if not present
+		int index(std::size_t n) const { return indexes[n]; }
+
+		void operator()(Record & rec) const
+		{
+			for_each_column<Record>([this, &rec](std::size_t n, const auto & col)
+			{
+				if (indexes[n] >= 0) get(*stmt, indexes[n], rec.*col.member);
+			});
+		}
+
+		Record operator()() const
+		{
+			Record rec {};
+			operator()(rec);
+			return rec;
+		}
+	};
+
+	/// one-off helpers, mapping is resolved on each call - prefer record_binder/record_getter in loops
+	template <class Record>
+	void bind_struct(statement & stmt, const Record & rec, bool forceCopy = false)
+	{
+		record_binder<Record>{stmt, forceCopy}(rec);
+	}
+
+	template <class Record>
+	void get_struct(statement & stmt, Record & rec)
+	{
+		record_getter<Record>{stmt}(rec);
+	}
+
+	template <class Record>
+	Record get_struct(statement & stmt)
+	{
+		return record_getter<Record>{stmt}();
+	}
+}
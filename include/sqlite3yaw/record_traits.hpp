@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace sqlite3yaw
+{
+	/// description of one record member mapped to table column
+	template <class Record, class Type>
+	struct column_desc
+	{
+		typedef Record record_type;
+		typedef Type   value_type;
+
+		const char * name;
+		Type Record::* member;
+		bool key;                 /// part of primary key
+	};
+
+	template <class Record, class Type>
+	constexpr column_desc<Record, Type> column(const char * name, Type Record::* member)
+	{
+		return {name, member, false};
+	}
+
+	template <class Record, class Type>
+	constexpr column_desc<Record, Type> key_column(const char * name, Type Record::* member)
+	{
+		return {name, member, true};
+	}
+
+	/// compile time description of record mapped to table, specialize for your type:
+	///
+	/// template <> struct sqlite3yaw::record_traits<person>
+	/// {
+	///     static constexpr const char * table = "person";
+	///     static constexpr auto columns = std::make_tuple(
+	///         sqlite3yaw::key_column("id", &person::id),
+	///         sqlite3yaw::column("name", &person::name));
+	/// };
+	///
+	/// columns order is order of binding/reading in commands generated from description
+	template <class Record>
+	struct record_traits;
+
+	template <class Record, class = void>
+	struct has_record_traits : std::false_type {};
+
+	template <class Record>
+	struct has_record_traits<Record, std::void_t<decltype(record_traits<Record>::columns)>> : std::true_type {};
+
+	template <class Record>
+	inline constexpr std::size_t record_column_count = std::tuple_size<std::decay_t<decltype(record_traits<Record>::columns)>>::value;
+
+	/// calls func(index, column_desc) for each column of Record, index is 0-based position in columns
+	template <class Record, class Functor>
+	constexpr void for_each_column(Functor && func)
+	{
+		std::apply([&func](const auto & ... cols)
+		{
+			std::size_t idx = 0;
+			(func(idx++, cols), ...);
+		}, record_traits<Record>::columns);
+	}
+}
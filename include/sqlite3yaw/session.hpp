@@ -7,10 +7,20 @@
 #include <sqlite3yaw/sqlite3inc.h>
 #include <sqlite3yaw/exceptions.hpp>
 #include <sqlite3yaw/statement.hpp>
+#include <sqlite3yaw/statement_cache.hpp>
+#include <sqlite3yaw/status.hpp>
 #include <sqlite3yaw/to_int.hpp>
 
 namespace sqlite3yaw
 {
+	/// result of session::wal_checkpoint
+	struct wal_checkpoint_result
+	{
+		int log_frames = 0;           /// frames in WAL file
+		int checkpointed_frames = 0;  /// frames checkpointed into database, whole WAL if equal to log_frames
+		bool busy = false;            /// checkpoint could not complete because of readers/writers(SQLITE_BUSY/SQLITE_LOCKED)
+	};
+
 	class session
 	{
 		//functor that can close sqlite3 handles. For unique_ptr
@@ -32,6 +42,8 @@ namespace sqlite3yaw
 
 
 		std::unique_ptr<sqlite3, AutoClose> db;
+		// declared after db: cached statements must be finalized before connection is closed
+		std::shared_ptr<statement_cache> stmt_cache;
 
 	public:
 		session(const session &) = delete;
@@ -42,6 +54,7 @@ namespace sqlite3yaw
 		friend void swap(session & s1, session & s2) noexcept
 		{
 			std::swap(s1.db, s2.db);
+			std::swap(s1.stmt_cache, s2.stmt_cache);
 		}
 
 		session(sqlite3 * db_) noexcept : db(db_) {}
@@ -96,6 +109,7 @@ namespace sqlite3yaw
 
 		void close()
 		{
+			clear_statement_cache();
 			if (db) {
 				int res = sqlite3_close(db.get());
 				check_result(res);
@@ -106,6 +120,7 @@ namespace sqlite3yaw
 		//you probably should use close(), see doc for sqlite3_close_v2
 		void close_v2()
 		{
+			clear_statement_cache();
 			if (db) {
 				int res = sqlite3_close_v2(db.get());
 				check_result(res);
@@ -149,6 +164,55 @@ namespace sqlite3yaw
 			return prepare_ex(command.c_str(), command.size(), stmt, nullptr);
 		}
 
+		/// enables statement cache used by prepare_cached with given capacity.
+		/// if cache was already enabled - it is cleared and recreated
+		void enable_statement_cache(std::size_t capacity)
+		{
+			stmt_cache = std::make_shared<statement_cache>(capacity);
+		}
+
+		/// disables statement cache, cached statements are finalized,
+		/// statements leased by prepare_cached at this moment are finalized when their leases are destroyed
+		void disable_statement_cache() noexcept
+		{
+			stmt_cache.reset();
+		}
+
+		bool statement_cache_enabled() const noexcept { return static_cast<bool>(stmt_cache); }
+
+		/// finalizes all cached statements, cache stays enabled
+		void clear_statement_cache() noexcept
+		{
+			if (stmt_cache) stmt_cache->clear();
+		}
+
+		/// statistics of statement cache, all zeros if cache is not enabled
+		statement_cache_stats cache_stats() const noexcept
+		{
+			return stmt_cache ? stmt_cache->stats() : statement_cache_stats();
+		}
+
+		/// prepares statement through statement cache, see enable_statement_cache.
+		/// returned lease resets statement, clears bindings and returns it to cache on destruction.
+		/// if cache is not enabled - behaves as prepare, and statement is finalized on lease destruction
+		cached_statement prepare_cached(const char * command)
+		{
+			return prepare_cached(std::string(command));
+		}
+
+		cached_statement prepare_cached(std::string command)
+		{
+			if (!stmt_cache)
+			{
+				auto stmt = prepare(command);
+				return cached_statement(nullptr, std::move(command), std::move(stmt));
+			}
+
+			auto stmt = stmt_cache->take(command);
+			if (!stmt) stmt = prepare(command);
+			return cached_statement(stmt_cache, std::move(command), std::move(stmt));
+		}
+
 		void exec(const std::string & commands)
 		{
 			return exec(commands.c_str());
@@ -204,6 +268,10 @@ namespace sqlite3yaw
 		const char * /*db_*/filename(const char * zDbName = nullptr) const    { return sqlite3_db_filename(db.get(), zDbName); }
 		bool /*db_*/readonly(const char * zDbName = nullptr) const            { return sqlite3_db_readonly(db.get(), zDbName) != 0; }
 
+		/// connection statistics(sqlite3_db_status): page cache, lookaside, schema and statement memory.
+		/// reset - resets counters after reading, see also delta(db_stats, db_stats)
+		db_stats stats(bool reset = false) const noexcept { return db_status(db.get(), reset); }
+
 		//hooks
 		//int (* hook)(Type * userArg)
 		template <class Type>
@@ -231,6 +299,39 @@ namespace sqlite3yaw
 				arg);
 		}
 
+		//int (* hook)(Type * userArg, sqlite3 * db, char const * dbname, int walFrames)
+		//called after each commit in WAL mode. Setting it disables wal_autocheckpoint
+		template <class Type>
+		void * wal_hook(int (* hook)(Type *, sqlite3 *, char const *, int), Type * arg)
+		{
+			return sqlite3_wal_hook(db.get(),
+				reinterpret_cast<int (*)(void *, sqlite3 *, char const *, int)>(hook), arg);
+		}
+
+		/// automatic checkpoint after commit if WAL has at least frames frames, 0 or negative - disabled. default is 1000
+		void wal_autocheckpoint(int frames) { check_result( sqlite3_wal_autocheckpoint(db.get(), frames) ); }
+
+		/// runs checkpoint of database dbName(nullptr - all attached databases),
+		/// mode - SQLITE_CHECKPOINT_PASSIVE/FULL/RESTART/TRUNCATE.
+		/// SQLITE_BUSY/SQLITE_LOCKED are reported by result.busy, other errors are thrown
+		wal_checkpoint_result wal_checkpoint(int mode = SQLITE_CHECKPOINT_PASSIVE, const char * dbName = nullptr)
+		{
+			wal_checkpoint_result result;
+			int res = sqlite3_wal_checkpoint_v2(db.get(), dbName, mode, &result.log_frames, &result.checkpointed_frames);
+			result.busy = res == SQLITE_BUSY || res == SQLITE_LOCKED;
+			check_result_ex(res);
+			return result;
+		}
+
+		//int (* hook)(unsigned traceType, Type * userArg, void * p, void * x), see sqlite3_trace_v2
+		template <class Type>
+		void trace_v2(unsigned mask, int (* hook)(unsigned, Type *, void *, void *), Type * arg)
+		{
+			int res = sqlite3_trace_v2(db.get(), mask,
+				reinterpret_cast<int (*)(unsigned, void *, void *, void *)>(hook), arg);
+			check_result(res);
+		}
+
 	private:
 		void check_result(int code)
 		{
@@ -247,16 +348,12 @@ namespace sqlite3yaw
 
 	/*
 		SQLITE_API int sqlite3_db_config(sqlite3*, int op, ...);
-		SQLITE_API void *sqlite3_trace(sqlite3*, void(*xTrace)(void*,const char*), void*);
 				
 		SQLITE_API sqlite3_stmt *sqlite3_next_stmt(sqlite3 *pDb, sqlite3_stmt *pStmt);
 		
 		SQLITE_API int sqlite3_overload_function(sqlite3*, const char *zFuncName, int nArg);
 		SQLITE_API sqlite3_mutex *sqlite3_db_mutex(sqlite3*);
 		SQLITE_API int sqlite3_file_control(sqlite3*, const char *zDbName, int op, void*);
-		SQLITE_API int sqlite3_db_status(sqlite3*, int op, int *pCur, int *pHiwtr, int resetFlg);
-		SQLITE_API int sqlite3_wal_autocheckpoint(sqlite3 *db, int N);
-		SQLITE_API int sqlite3_wal_checkpoint(sqlite3 *db, const char *zDb);
 		SQLITE_API int sqlite3_vtab_config(sqlite3*, int op, ...);
 		SQLITE_API int sqlite3_vtab_on_conflict(sqlite3 *);
 	*/
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sqlite3yaw/session.hpp>
+
+namespace sqlite3yaw
+{
+	struct session_pool_options
+	{
+		/// number of read-only connections, 0 - std::thread::hardware_concurrency()
+		std::size_t readers = 0;
+		/// capacity of statement cache of each connection, 0 - cache disabled
+		std::size_t statement_cache = 64;
+		/// busy timeout of each connection in milliseconds
+		int busy_timeout = 5000;
+		/// additional flags for sqlite3_open_v2, for example SQLITE_OPEN_URI
+		int open_flags = 0;
+		const char * vfs = nullptr;
+	};
+
+	/// database can't be switched into WAL mode: in-memory database, VFS without shared memory, etc.
+	/// readers of pool would not run concurrently with writer there
+	struct wal_not_supported : std::invalid_argument
+	{
+		wal_not_supported(const std::string & path, const std::string & mode)
+			: std::invalid_argument("session_pool: database " + path + " can't use WAL, journal_mode is " + mode) {}
+	};
+
+	class session_pool;
+
+	/// RAII checkout of session from session_pool, session is returned to pool on destruction.
+	/// statements(including cached ones) of this session must not outlive lease
+	class pooled_session
+	{
+		friend session_pool;
+
+		session_pool * pool = nullptr;
+		session * ses = nullptr;
+
+		pooled_session(session_pool * pool_, session * ses_) noexcept : pool(pool_), ses(ses_) {}
+
+	public:
+		pooled_session(const pooled_session &) = delete;
+		pooled_session & operator =(const pooled_session &) = delete;
+
+		pooled_session() = default;
+		pooled_session(pooled_session && r) noexcept
+			: pool(std::exchange(r.pool, nullptr)), ses(std::exchange(r.ses, nullptr)) {}
+
+		pooled_session & operator =(pooled_session && r) noexcept
+		{
+			if (this != &r)
+			{
+				release();
+				pool = std::exchange(r.pool, nullptr);
+				ses = std::exchange(r.ses, nullptr);
+			}
+
+			return *this;
+		}
+
+		~pooled_session() noexcept { release(); }
+
+		session & operator *()  const noexcept { return *ses; }
+		session * operator ->() const noexcept { return ses; }
+		session * get() const noexcept { return ses; }
+
+		explicit operator bool() const noexcept { return ses != nullptr; }
+
+		/// returns session to pool now, lease becomes empty
+		inline void release() noexcept;
+	};
+
+	/// pool of connections to one WAL database: one writer and N read-only readers.
+	/// sqlite allows concurrent readers with one writer in WAL mode,
+	/// so reads scale with number of readers, while writes are serialized through writer.
+	///
+	/// connections are opened with SQLITE_OPEN_NOMUTEX, each connection is used by one thread at a time.
+	/// waiting for connection is fair: waiters are served in order of arrival.
+	/// pool must outlive all leases.
+	class session_pool
+	{
+		friend pooled_session;
+
+		/// FIFO queue of same kind connections
+		struct queue_type
+		{
+			std::vector<session> sessions;
+			std::vector<session *> free;
+			std::uint64_t next_ticket = 0;
+			std::uint64_t serving_ticket = 0;
+			std::condition_variable cond;
+		};
+
+		std::mutex mutex;
+		queue_type writer_queue;
+		queue_type reader_queue;
+
+	private:
+		pooled_session acquire(queue_type & queue)
+		{
+			std::unique_lock<std::mutex> lk(mutex);
+			auto ticket = queue.next_ticket++;
+			queue.cond.wait(lk, [&] { return ticket == queue.serving_ticket && !queue.free.empty(); });
+
+			++queue.serving_ticket;
+			session * ses = queue.free.back();
+			queue.free.pop_back();
+			lk.unlock();
+
+			// next in line may be able to proceed too
+			queue.cond.notify_all();
+			return pooled_session(this, ses);
+		}
+
+		void release(session * ses) noexcept
+		{
+			auto & queue = is_writer(ses) ? writer_queue : reader_queue;
+			{
+				std::lock_guard<std::mutex> lk(mutex);
+				queue.free.push_back(ses);
+			}
+
+			queue.cond.notify_all();
+		}
+
+		bool is_writer(const session * ses) const noexcept
+		{
+			return ses == &writer_queue.sessions.front();
+		}
+
+		/// pragma returns new journal mode, it's left unchanged if WAL is not possible
+		static void enable_wal(session & ses, const std::string & path)
+		{
+			auto stmt = ses.prepare("pragma journal_mode = wal");
+			std::string mode = stmt.step() ? stmt.column_string(0) : std::string();
+			if (mode != "wal")
+				throw wal_not_supported(path, mode);
+		}
+
+		static void prepare_session(session & ses, const session_pool_options & opts)
+		{
+			ses.busy_timeout(opts.busy_timeout);
+			if (opts.statement_cache)
+				ses.enable_statement_cache(opts.statement_cache);
+		}
+
+	public:
+		session_pool(const session_pool &) = delete;
+		session_pool & operator =(const session_pool &) = delete;
+
+		/// opens writer, switches database into WAL mode, then opens readers.
+		/// throws wal_not_supported if database can't be switched to WAL
+		session_pool(const std::string & path, const session_pool_options & opts = {})
+		{
+			const int flags = SQLITE_OPEN_NOMUTEX | opts.open_flags;
+
+			writer_queue.sessions.emplace_back(path, flags | SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, opts.vfs);
+			auto & writer = writer_queue.sessions.front();
+			prepare_session(writer, opts);
+			enable_wal(writer, path);
+
+			auto readers = opts.readers ? opts.readers : std::max(1u, std::thread::hardware_concurrency());
+			reader_queue.sessions.reserve(readers);
+			for (std::size_t i = 0; i < readers; ++i)
+			{
+				reader_queue.sessions.emplace_back(path, flags | SQLITE_OPEN_READONLY, opts.vfs);
+				prepare_session(reader_queue.sessions.back(), opts);
+			}
+
+			writer_queue.free.push_back(&writer);
+			for (auto & ses : reader_queue.sessions)
+				reader_queue.free.push_back(&ses);
+		}
+
+		~session_pool() noexcept
+		{
+			assert(writer_queue.free.size() == writer_queue.sessions.size());
+			assert(reader_queue.free.size() == reader_queue.sessions.size());
+		}
+
+		/// checks out read-only connection, waits if all readers are busy
+		pooled_session reader() { return acquire(reader_queue); }
+		/// checks out writer connection, waits if it is busy
+		pooled_session writer() { return acquire(writer_queue); }
+
+		std::size_t readers_count() const noexcept { return reader_queue.sessions.size(); }
+	};
+
+	inline void pooled_session::release() noexcept
+	{
+		if (ses)
+		{
+			pool->release(ses);
+			pool = nullptr;
+			ses = nullptr;
+		}
+	}
+}
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 #include <sqlite3yaw/config.hpp>
 #include <sqlite3yaw/sqlite3inc.h>
@@ -11,9 +16,42 @@
 
 namespace sqlite3yaw
 {
+	namespace detail
+	{
+		/// sorted column name -> index map, see statement::column_index
+		struct column_index_map
+		{
+			std::vector<std::pair<std::string, int>> names;
+			int reprepares;   // SQLITE_STMTSTATUS_REPREPARE at moment of building
+
+			column_index_map(sqlite3_stmt * stmt)
+			{
+				reprepares = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_REPREPARE, 0);
+				int count = sqlite3_column_count(stmt);
+				names.reserve(count);
+				for (int i = 0; i < count; ++i)
+					names.emplace_back(sqlite3_column_name(stmt, i), i);
+
+				// stable: for duplicate names first column wins, same as linear search
+				std::stable_sort(names.begin(), names.end(),
+					[](auto & n1, auto & n2) { return n1.first < n2.first; });
+			}
+
+			int find(const char * name) const
+			{
+				auto it = std::lower_bound(names.begin(), names.end(), name,
+					[](auto & n, const char * name) { return std::strcmp(n.first.c_str(), name) < 0; });
+
+				return it != names.end() && it->first == name ? it->second : -1;
+			}
+		};
+	}
+
 	class statement
 	{
 		sqlite3_stmt * stmt;
+		// lazily built by column_index
+		mutable std::unique_ptr<detail::column_index_map> colidx;
 
 
 	public:
@@ -22,7 +60,7 @@ namespace sqlite3yaw
 
 		statement() noexcept : stmt(nullptr) {};
 		statement(sqlite3_stmt * stmt_) noexcept : stmt(stmt_) {};
-		statement(statement && r) noexcept : stmt(r.release()) {}
+		statement(statement && r) noexcept : stmt(r.stmt), colidx(std::move(r.colidx)) { r.stmt = nullptr; }
 
 		statement & operator =(statement && r) noexcept
 		{
@@ -30,6 +68,7 @@ namespace sqlite3yaw
 			{
 				finalize();
 				stmt = std::exchange(r.stmt, nullptr);
+				colidx = std::move(r.colidx);
 			}
 			
 			return *this;
@@ -38,6 +77,7 @@ namespace sqlite3yaw
 		friend void swap(statement & s1, statement & s2) noexcept
 		{
 			std::swap(s1.stmt, s2.stmt);
+			std::swap(s1.colidx, s2.colidx);
 		}
 
 		~statement() noexcept
@@ -51,6 +91,7 @@ namespace sqlite3yaw
 		{
 			sqlite3_stmt * ret = stmt;
 			stmt = nullptr;
+			colidx.reset();
 			return ret;
 		}
 
@@ -114,6 +155,23 @@ namespace sqlite3yaw
 			bind_text(idx, str.data(), ToInt(str.size()), copy);
 		}
 		
+		/// binds blob via sqlite3_bind_blob64, zero sized blob is bound as zeroblob(0), not as null
+		/// @Param copy - SQLITE_STATIC or SQLITE_TRANSIENT
+		void bind_blob(int idx, const void * data, std::size_t size, bool copy)
+		{
+			if (size == 0)
+				check_result(sqlite3_bind_zeroblob(stmt, idx, 0));
+			else
+				check_result(sqlite3_bind_blob64(stmt, idx, data, size, copy ? SQLITE_TRANSIENT : SQLITE_STATIC));
+		}
+
+		/// binds pointer value(sqlite 3.20+), visible to SQL as NULL and only to functions asking for same type string.
+		/// type must be static string, destroy is called when binding is released, also on failure
+		void bind_pointer(int idx, void * ptr, const char * type, void (* destroy)(void *))
+		{
+			check_result(sqlite3_bind_pointer(stmt, idx, ptr, type, destroy));
+		}
+
 		/// sqlite3_reset returns most recent error code if any
 		/// pass it to user, it's not a error
 		int reset() noexcept {return sqlite3_reset(stmt);}
@@ -160,6 +218,13 @@ namespace sqlite3yaw
 			return sqlite3_bind_parameter_count(stmt);
 		}
 
+		/// sqlite3_stmt_status, op - SQLITE_STMTSTATUS_*.
+		/// do not reset SQLITE_STMTSTATUS_REPREPARE - column_index relies on it
+		int status(int op, bool reset = false) const
+		{
+			return sqlite3_stmt_status(stmt, op, reset);
+		}
+
 		/// result functions
 		const char * column_name(int idx) const        { return sqlite3_column_name(stmt, idx); }
 		int column_count() const                       { return sqlite3_column_count(stmt); }
@@ -167,6 +232,18 @@ namespace sqlite3yaw
 		int column_type(int idx) const                 { return sqlite3_column_type(stmt, idx); }
 		const char * column_decltype(int idx) const    { return sqlite3_column_decltype(stmt, idx); }
 
+		/// returns index of column with given name, -1 if not found. Comparison is case sensitive.
+		/// name -> index map is built on first call and rebuilt if statement was reprepared by sqlite
+		int column_index(const char * name) const
+		{
+			if (!colidx || colidx->reprepares != sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_REPREPARE, 0))
+				colidx = std::make_unique<detail::column_index_map>(stmt);
+
+			return colidx->find(name);
+		}
+
+		int column_index(const std::string & name) const { return column_index(name.c_str()); }
+
 		int column_int(int idx) const                  { return sqlite3_column_int(stmt, idx); }
 		sqlite3_int64 column_int64(int idx) const      { return sqlite3_column_int64(stmt, idx); }
 		double column_double(int idx) const            { return sqlite3_column_double(stmt, idx); }
@@ -190,6 +267,19 @@ namespace sqlite3yaw
 			return str;
 		}
 
+		/// returns text of column without copying.
+		/// view is valid until next step/reset/finalize or type conversion of this column
+		std::string_view column_string_view(int idx) const
+		{
+			auto text = column_text(idx);
+			auto sz = column_bytes(idx);
+			return text ? std::string_view(text, sz) : std::string_view();
+		}
+
+		/// returns blob of column, for zero sized blob returns null pointer.
+		/// pointer is valid until next step/reset/finalize or type conversion of this column
+		const void * column_blob(int idx) const { return sqlite3_column_blob(stmt, idx); }
+
 		/// metadata interface
 		const char * column_database_name(int n) const { return sqlite3_column_database_name(stmt, n); }
 		const char * column_table_name(int n) const    { return sqlite3_column_table_name(stmt, n); }
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <unordered_map>
+
+#include <sqlite3yaw/sqlite3inc.h>
+#include <sqlite3yaw/statement.hpp>
+
+namespace sqlite3yaw
+{
+	struct statement_cache_stats
+	{
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+		std::size_t evictions = 0;
+	};
+
+	/// bounded LRU cache of prepared statements keyed by sql text.
+	/// statements are taken out of cache while they are in use(see cached_statement),
+	/// so same sql can be used simultaneously by several leases, each one gets it's own statement.
+	/// not thread safe, same as sqlite3 connection itself(in multi-thread mode)
+	class statement_cache
+	{
+		typedef std::pair<std::string, statement> item_type;
+		typedef std::list<item_type> list_type;
+		typedef std::unordered_map<std::string, list_type::iterator> map_type;
+
+		std::size_t capacity;
+		list_type items;    // front - most recently used
+		map_type index;
+		statement_cache_stats counters;
+
+	public:
+		statement_cache(const statement_cache &) = delete;
+		statement_cache & operator =(const statement_cache &) = delete;
+
+		explicit statement_cache(std::size_t capacity_) : capacity(capacity_) {}
+
+		std::size_t size() const noexcept                  { return items.size(); }
+		std::size_t max_size() const noexcept              { return capacity; }
+		const statement_cache_stats & stats() const noexcept { return counters; }
+		void reset_stats() noexcept                        { counters = {}; }
+
+		/// finalizes all cached statements, statements in use are not affected
+		void clear() noexcept
+		{
+			index.clear();
+			items.clear();
+		}
+
+		/// takes statement for sql from cache, if there is one, returns empty statement otherwise.
+		/// hit/miss counters are updated
+		statement take(const std::string & sql)
+		{
+			auto it = index.find(sql);
+			if (it == index.end())
+			{
+				++counters.misses;
+				return statement();
+			}
+
+			++counters.hits;
+			auto lit = it->second;
+			statement stmt = std::move(lit->second);
+			index.erase(it);
+			items.erase(lit);
+			return stmt;
+		}
+
+		/// returns statement into cache as most recently used.
+		/// statement should be already reset, if cache is full - least recently used statement is finalized.
+		/// if there is already statement for same sql - given one is finalized
+		void put(std::string sql, statement stmt) noexcept
+		{
+			if (capacity == 0 || index.count(sql))
+				return;
+
+			// on allocation failure statement is just finalized
+			try { items.emplace_front(std::move(sql), std::move(stmt)); }
+			catch (std::bad_alloc &) { return; }
+
+			try { index.emplace(items.front().first, items.begin()); }
+			catch (std::bad_alloc &) { items.pop_front(); return; }
+
+			while (items.size() > capacity)
+			{
+				index.erase(items.back().first);
+				items.pop_back();
+				++counters.evictions;
+			}
+		}
+	};
+
+	/// RAII lease of cached statement, returned by session::prepare_cached.
+	/// On destruction statement is reset, bindings are cleared and statement is returned into cache.
+	/// lease keeps cache alive, but must not outlive session connection from which it was acquired
+	class cached_statement
+	{
+		std::shared_ptr<statement_cache> cache;
+		std::string sql;
+		statement stmt;
+
+	public:
+		cached_statement(const cached_statement &) = delete;
+		cached_statement & operator =(const cached_statement &) = delete;
+
+		cached_statement() = default;
+		cached_statement(std::shared_ptr<statement_cache> cache_, std::string sql_, statement stmt_) noexcept
+			: cache(std::move(cache_)), sql(std::move(sql_)), stmt(std::move(stmt_)) {}
+
+		cached_statement(cached_statement && r) noexcept
+			: cache(std::move(r.cache)), sql(std::move(r.sql)), stmt(std::move(r.stmt)) {}
+
+		cached_statement & operator =(cached_statement && r) noexcept
+		{
+			if (this != &r)
+			{
+				release_to_cache();
+				cache = std::move(r.cache);
+				sql = std::move(r.sql);
+				stmt = std::move(r.stmt);
+			}
+
+			return *this;
+		}
+
+		~cached_statement() noexcept { release_to_cache(); }
+
+		      statement & get()       noexcept { return stmt; }
+		const statement & get() const noexcept { return stmt; }
+
+		      statement & operator *()       noexcept { return stmt; }
+		const statement & operator *() const noexcept { return stmt; }
+		      statement * operator ->()       noexcept { return &stmt; }
+		const statement * operator ->() const noexcept { return &stmt; }
+
+		operator       statement &()       noexcept { return stmt; }
+		operator const statement &() const noexcept { return stmt; }
+
+		explicit operator bool() const noexcept { return static_cast<bool>(stmt); }
+
+		/// returns statement into cache now, lease becomes empty
+		void release_to_cache() noexcept
+		{
+			if (!stmt) return;
+
+			stmt.reset();
+			sqlite3_clear_bindings(stmt.native());
+
+			if (cache)
+				cache->put(std::move(sql), std::move(stmt));
+
+			stmt.finalize();
+			cache.reset();
+		}
+	};
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <sqlite3yaw/sqlite3inc.h>
+
+namespace sqlite3yaw
+{
+	/// connection statistics, see sqlite3_db_status.
+	/// counters(hit/miss/write/spill) grow until reset, others are current values(gauges).
+	/// values not supported by runtime sqlite are 0
+	struct db_stats
+	{
+		std::int64_t cache_used = 0;               /// bytes of heap used by page cache
+		std::int64_t cache_used_shared = 0;        /// same, shared cache memory divided between connections
+		std::int64_t cache_hit = 0;                /// counter
+		std::int64_t cache_miss = 0;               /// counter
+		std::int64_t cache_write = 0;              /// counter, dirty pages written to disk
+		std::int64_t cache_spill = 0;              /// counter, dirty pages written in the middle of transaction(cache was full)
+
+		std::int64_t lookaside_used = 0;           /// lookaside slots in use
+		std::int64_t lookaside_used_highwater = 0;
+		std::int64_t lookaside_hit = 0;            /// counter, highwater of sqlite
+		std::int64_t lookaside_miss_size = 0;      /// counter, highwater of sqlite
+		std::int64_t lookaside_miss_full = 0;      /// counter, highwater of sqlite
+
+		std::int64_t schema_used = 0;              /// bytes of heap used by schema
+		std::int64_t stmt_used = 0;                /// bytes of heap used by prepared statements
+		std::int64_t deferred_fks = 0;             /// 1 if there are unresolved deferred foreign key constraints
+
+		/// cache_hit / (cache_hit + cache_miss), 0 if no lookups
+		double cache_hit_ratio() const noexcept
+		{
+			auto total = cache_hit + cache_miss;
+			return total ? static_cast<double>(cache_hit) / total : 0;
+		}
+	};
+
+	/// process-wide sqlite memory statistics, see sqlite3_status64.
+	/// each value has current value and highwater mark
+	struct memory_stats
+	{
+		std::int64_t memory_used = 0;              /// bytes allocated by sqlite3_malloc
+		std::int64_t memory_used_highwater = 0;
+		std::int64_t malloc_count = 0;             /// outstanding allocations
+		std::int64_t malloc_count_highwater = 0;
+		std::int64_t malloc_size_highwater = 0;    /// largest allocation request
+		std::int64_t pagecache_used = 0;           /// pages used from SQLITE_CONFIG_PAGECACHE memory
+		std::int64_t pagecache_used_highwater = 0;
+		std::int64_t pagecache_overflow = 0;       /// bytes of page cache which did not fit into SQLITE_CONFIG_PAGECACHE
+		std::int64_t pagecache_overflow_highwater = 0;
+		std::int64_t pagecache_size_highwater = 0; /// largest page cache allocation request
+	};
+
+	namespace detail
+	{
+		inline void db_status_value(sqlite3 * db, int op, bool reset, std::int64_t * cur, std::int64_t * hiwtr) noexcept
+		{
+			int c = 0, h = 0;
+			if (sqlite3_db_status(db, op, &c, &h, reset) != SQLITE_OK) return;
+
+			if (cur) *cur = c;
+			if (hiwtr) *hiwtr = h;
+		}
+
+		inline void status_value(int op, bool reset, std::int64_t * cur, std::int64_t * hiwtr) noexcept
+		{
+			sqlite3_int64 c = 0, h = 0;
+			if (sqlite3_status64(op, &c, &h, reset) != SQLITE_OK) return;
+
+			if (cur) *cur = c;
+			if (hiwtr) *hiwtr = h;
+		}
+	}
+
+	/// reads connection statistics, reset - resets counters and highwaters after reading
+	inline db_stats db_status(sqlite3 * db, bool reset = false) noexcept
+	{
+		using detail::db_status_value;
+		db_stats st;
+
+		db_status_value(db, SQLITE_DBSTATUS_CACHE_USED, false, &st.cache_used, nullptr);
+#ifdef SQLITE_DBSTATUS_CACHE_USED_SHARED
+		db_status_value(db, SQLITE_DBSTATUS_CACHE_USED_SHARED, false, &st.cache_used_shared, nullptr);
+#endif
+		db_status_value(db, SQLITE_DBSTATUS_CACHE_HIT, reset, &st.cache_hit, nullptr);
+		db_status_value(db, SQLITE_DBSTATUS_CACHE_MISS, reset, &st.cache_miss, nullptr);
+		db_status_value(db, SQLITE_DBSTATUS_CACHE_WRITE, reset, &st.cache_write, nullptr);
+#ifdef SQLITE_DBSTATUS_CACHE_SPILL
+		db_status_value(db, SQLITE_DBSTATUS_CACHE_SPILL, reset, &st.cache_spill, nullptr);
+#endif
+
+		db_status_value(db, SQLITE_DBSTATUS_LOOKASIDE_USED, reset, &st.lookaside_used, &st.lookaside_used_highwater);
+		db_status_value(db, SQLITE_DBSTATUS_LOOKASIDE_HIT, reset, nullptr, &st.lookaside_hit);
+		db_status_value(db, SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, reset, nullptr, &st.lookaside_miss_size);
+		db_status_value(db, SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, reset, nullptr, &st.lookaside_miss_full);
+
+		db_status_value(db, SQLITE_DBSTATUS_SCHEMA_USED, false, &st.schema_used, nullptr);
+		db_status_value(db, SQLITE_DBSTATUS_STMT_USED, false, &st.stmt_used, nullptr);
+		db_status_value(db, SQLITE_DBSTATUS_DEFERRED_FKS, false, &st.deferred_fks, nullptr);
+
+		return st;
+	}
+
+	/// reads process-wide memory statistics, reset - resets highwaters after reading
+	inline memory_stats memory_status(bool reset = false) noexcept
+	{
+		using detail::status_value;
+		memory_stats st;
+
+		status_value(SQLITE_STATUS_MEMORY_USED, reset, &st.memory_used, &st.memory_used_highwater);
+		status_value(SQLITE_STATUS_MALLOC_COUNT, reset, &st.malloc_count, &st.malloc_count_highwater);
+		status_value(SQLITE_STATUS_MALLOC_SIZE, reset, nullptr, &st.malloc_size_highwater);
+		status_value(SQLITE_STATUS_PAGECACHE_USED, reset, &st.pagecache_used, &st.pagecache_used_highwater);
+		status_value(SQLITE_STATUS_PAGECACHE_OVERFLOW, reset, &st.pagecache_overflow, &st.pagecache_overflow_highwater);
+		status_value(SQLITE_STATUS_PAGECACHE_SIZE, reset, nullptr, &st.pagecache_size_highwater);
+
+		return st;
+	}
+
+	/// difference between two snapshots: counters are after - before, gauges are taken from after
+	inline db_stats delta(const db_stats & before, const db_stats & after) noexcept
+	{
+		db_stats d = after;
+		d.cache_hit           -= before.cache_hit;
+		d.cache_miss          -= before.cache_miss;
+		d.cache_write         -= before.cache_write;
+		d.cache_spill         -= before.cache_spill;
+		d.lookaside_hit       -= before.lookaside_hit;
+		d.lookaside_miss_size -= before.lookaside_miss_size;
+		d.lookaside_miss_full -= before.lookaside_miss_full;
+		return d;
+	}
+
+	/// difference between two snapshots: current values are after - before(growth), highwaters are taken from after
+	inline memory_stats delta(const memory_stats & before, const memory_stats & after) noexcept
+	{
+		memory_stats d = after;
+		d.memory_used        -= before.memory_used;
+		d.malloc_count       -= before.malloc_count;
+		d.pagecache_used     -= before.pagecache_used;
+		d.pagecache_overflow -= before.pagecache_overflow;
+		return d;
+	}
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include <cctype>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/iterator/iterator_facade.hpp>
+#include <sqlite3yaw/query.hpp>
+#include <sqlite3yaw/record_traits.hpp>
+
+namespace sqlite3yaw
+{
+	struct row_type_mismatch : std::invalid_argument
+	{
+		row_type_mismatch(std::string const & what)
+			: std::invalid_argument("row type mismatch: " + what) {}
+	};
+
+	namespace detail
+	{
+		/// determines column affinity from declared type, as described in https://www.sqlite.org/datatype3.html 3.1
+		/// returns SQLITE_INTEGER, SQLITE_TEXT, SQLITE_BLOB, SQLITE_FLOAT or 0 for NUMERIC
+		inline int decltype_affinity(const char * decltype_)
+		{
+			std::string type = decltype_;
+			for (auto & ch : type) ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+
+			auto has = [&type](const char * str) { return type.find(str) != std::string::npos; };
+			if (has("INT")) return SQLITE_INTEGER;
+			if (has("CHAR") || has("CLOB") || has("TEXT")) return SQLITE_TEXT;
+			if (type.empty() || has("BLOB")) return SQLITE_BLOB;
+			if (has("REAL") || has("FLOA") || has("DOUB")) return SQLITE_FLOAT;
+			return 0;
+		}
+
+		template <class Type>
+		struct is_blob_type : std::false_type {};
+
+		template <class allocator>
+		struct is_blob_type<std::vector<std::byte, allocator>> : std::true_type {};
+
+		/// checks if value of column with given affinity can be sensibly read into Type.
+		/// any column can be read as string, so only numbers and blobs are checked
+		template <class Type>
+		bool affinity_compatible(int affinity)
+		{
+			if (std::is_arithmetic<Type>::value)
+				return affinity != SQLITE_TEXT && affinity != SQLITE_BLOB;
+			if (is_blob_type<Type>::value)
+				return affinity != SQLITE_INTEGER && affinity != SQLITE_FLOAT;
+			return true;
+		}
+
+		/// number of values in Row: tuple size or number of record_traits columns
+		template <class Row, class = void>
+		struct row_size : std::tuple_size<Row> {};
+
+		template <class Row>
+		struct row_size<Row, std::enable_if_t<has_record_traits<Row>::value>>
+			: std::integral_constant<std::size_t, record_column_count<Row>> {};
+	}
+
+	/// typed cursor over statement results, Row is tuple like type(std::tuple, std::pair, std::array)
+	/// or struct with record_traits specialization.
+	/// column count and declared column types are checked once at construction,
+	/// then each row is decoded by index with conv<std::tuple_element_t<I, Row>>.
+	/// record members are matched to columns by name once at construction, statement can have extra columns.
+	///
+	/// usage: for (const auto & [id, name] : query<std::tuple<int, std::string>>(stmt)) ...
+	///        for (const person & p : query<person>(stmt)) ...
+	///
+	/// row reference is valid until next step, query is single pass input range.
+	template <class Row>
+	class query
+	{
+		static constexpr bool is_record = has_record_traits<Row>::value;
+		static constexpr std::size_t column_count = detail::row_size<Row>::value;
+		typedef std::make_index_sequence<column_count> indexes;
+
+		statement * stmt;
+		Row row;
+		std::array<int, column_count> columns; // record member -> column index, unused for tuple rows
+
+	private:
+		template <std::size_t ... Is>
+		void check_types(std::index_sequence<Is...>) const
+		{
+			(check_type<std::tuple_element_t<Is, Row>>(static_cast<int>(Is)), ...);
+		}
+
+		void map_columns()
+		{
+			for_each_column<Row>([this](std::size_t n, const auto & col)
+			{
+				int idx = columns[n] = stmt->column_index(col.name);
+				if (idx == -1)
+					throw row_type_mismatch(std::string("statement has no column '") + col.name + "'");
+
+				typedef typename std::decay_t<decltype(col)>::value_type Type;
+				check_type<Type>(idx);
+			});
+		}
+
+		template <class Type>
+		void check_type(int idx) const
+		{
+			auto * decl = stmt->column_decltype(idx);
+			if (!decl || !*decl) return; // expression or untyped column, nothing known
+
+			typedef typename std::decay<Type>::type PureType;
+			if (!detail::affinity_compatible<PureType>(detail::decltype_affinity(decl)))
+				throw row_type_mismatch("column " + std::to_string(idx) + " '" + stmt->column_name(idx) + "' declared as " + decl);
+		}
+
+		template <std::size_t ... Is>
+		void decode(std::index_sequence<Is...>)
+		{
+			if constexpr (is_record)
+				for_each_column<Row>([this](std::size_t n, const auto & col) { sqlite3yaw::get(*stmt, columns[n], row.*col.member); });
+			else
+				(sqlite3yaw::get(*stmt, static_cast<int>(Is), std::get<Is>(row)), ...);
+		}
+
+	public:
+		class iterator :
+			public boost::iterator_facade<iterator, const Row, boost::single_pass_traversal_tag>
+		{
+			friend boost::iterator_core_access;
+			query * q = nullptr;
+
+			void increment()                          { if (!q->next()) q = nullptr; }
+			const Row & dereference() const           { return q->current(); }
+			bool equal(iterator const & other) const  { return q == other.q; }
+
+		public:
+			iterator() = default;
+			explicit iterator(query * q_) : q(q_) {}
+		};
+
+	public:
+		/// throws row_type_mismatch if statement column count is not equal to Row size(record: some column is missing),
+		/// or declared type of some column is not compatible with C++ type
+		explicit query(statement & stmt_) : stmt(&stmt_), columns()
+		{
+			if constexpr (is_record)
+				map_columns();
+			else
+			{
+				if (stmt->column_count() != static_cast<int>(column_count))
+					throw row_type_mismatch("statement has " + std::to_string(stmt->column_count()) +
+					                        " columns, row has " + std::to_string(column_count));
+				check_types(indexes());
+			}
+		}
+
+		/// steps statement and decodes row, returns false if there are no more rows
+		bool next()
+		{
+			if (!stmt->step()) return false;
+
+			decode(indexes());
+			return true;
+		}
+
+		const Row & current() const noexcept { return row; }
+		      Row & current()       noexcept { return row; }
+
+		/// steps to first row, query is single pass - begin should be called once
+		iterator begin() { return next() ? iterator(this) : iterator(); }
+		iterator end()   { return iterator(); }
+	};
+}
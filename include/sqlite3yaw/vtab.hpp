@@ -0,0 +1,679 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sqlite3yaw/sqlite3inc.h>
+#include <sqlite3yaw/exceptions.hpp>
+#include <sqlite3yaw/session.hpp>
+#include <sqlite3yaw/convert.hpp>
+#include <sqlite3yaw/record_traits.hpp>
+
+namespace sqlite3yaw
+{
+	/// options of C++ data exposed as virtual table, see create_range_table/create_column_table
+	struct vtab_options
+	{
+		/// columns for which sorted index(permutation of row numbers, 8 bytes per row) is built at registration,
+		/// equality and range constraints on them are resolved by binary search, ORDER BY on them is consumed.
+		/// only arithmetic and string columns can be indexed
+		std::vector<std::string> indexed;
+		/// column by which data is already sorted ascending(NaNs first), it's indexed without permutation. checked at registration
+		std::string sorted_by;
+	};
+
+	namespace detail
+	{
+		/// column of range of records: rows[n].*member
+		template <class Range, class Record, class Type>
+		struct record_column_ref
+		{
+			typedef Type value_type;
+
+			const char * name;
+			const Range * rows;
+			Type Record::* member;
+
+			std::size_t size() const { return static_cast<std::size_t>(std::distance(std::begin(*rows), std::end(*rows))); }
+			const Type & get(std::size_t n) const { return std::begin(*rows)[n].*member; }
+		};
+
+		/// column of column store: data[n]
+		template <class Container>
+		struct container_column_ref
+		{
+			typedef std::decay_t<decltype(*std::begin(std::declval<const Container &>()))> value_type;
+
+			const char * name;
+			const Container * data;
+
+			std::size_t size() const { return static_cast<std::size_t>(std::distance(std::begin(*data), std::end(*data))); }
+			const value_type & get(std::size_t n) const { return std::begin(*data)[n]; }
+		};
+
+		template <class Type>
+		struct is_vtab_string : std::false_type {};
+
+		template <class traits, class allocator>
+		struct is_vtab_string<std::basic_string<char, traits, allocator>> : std::true_type {};
+
+		template <class traits>
+		struct is_vtab_string<std::basic_string_view<char, traits>> : std::true_type {};
+
+		template <class Type>
+		constexpr bool vtab_indexable = std::is_arithmetic<Type>::value || is_vtab_string<Type>::value;
+
+		template <class Type>
+		const char * vtab_column_type()
+		{
+			if constexpr (std::is_integral<Type>::value)            return "INTEGER";
+			else if constexpr (std::is_floating_point<Type>::value) return "REAL";
+			else if constexpr (is_vtab_string<Type>::value)         return "TEXT";
+			else                                                     return "";
+		}
+
+		/// values are compared as sqlite sees them: integers as sqlite3_int64, floats as double, strings as bytes(BINARY collation)
+		template <class Type>
+		auto vtab_key(const Type & val)
+		{
+			if constexpr (std::is_integral<Type>::value)            return static_cast<sqlite3_int64>(val);
+			else if constexpr (std::is_floating_point<Type>::value) return static_cast<double>(val);
+			else                                                     return std::string_view(val.data(), val.size());
+		}
+
+		/// strict weak order of keys: NaN is ordered before all other values(sqlite sees it as NULL, which sorts first)
+		template <class Key>
+		bool vtab_less(const Key & k1, const Key & k2)
+		{
+			if constexpr (std::is_floating_point<Key>::value)
+				return std::isnan(k1) ? !std::isnan(k2) : k1 < k2;
+			else
+				return k1 < k2;
+		}
+
+		/// decodes constraint value as key of Type column, returns false if storage class does not match
+		/// and such constraint can't be used for narrowing
+		template <class Type, class Key>
+		bool vtab_value_key(sqlite3_value * value, Key & key)
+		{
+			int type = sqlite3_value_type(value);
+			if constexpr (std::is_integral<Type>::value)
+			{
+				if (type != SQLITE_INTEGER) return false;
+				key = sqlite3_value_int64(value);
+			}
+			else if constexpr (std::is_floating_point<Type>::value)
+			{
+				if (type != SQLITE_INTEGER && type != SQLITE_FLOAT) return false;
+				key = sqlite3_value_double(value);
+				if (std::isnan(key)) return false;
+			}
+			else
+			{
+				if (type != SQLITE_TEXT) return false;
+				auto * text = reinterpret_cast<const char *>(sqlite3_value_text(value));
+				key = text ? std::string_view(text, sqlite3_value_bytes(value)) : std::string_view();
+			}
+
+			return true;
+		}
+
+		/// first position in [lo, hi) for which pred is false, pred must be partitioned
+		template <class Pred>
+		std::size_t vtab_partition_point(std::size_t lo, std::size_t hi, Pred pred)
+		{
+			while (lo < hi)
+			{
+				std::size_t mid = lo + (hi - lo) / 2;
+				if (pred(mid)) lo = mid + 1;
+				else           hi = mid;
+			}
+
+			return lo;
+		}
+
+		/// constraint kinds encoded in idxNum of xBestIndex/xFilter, column + 1 is in low byte
+		enum : int
+		{
+			vtab_eq = 1 << 8,
+			vtab_gt = 1 << 9,
+			vtab_ge = 1 << 10,
+			vtab_lt = 1 << 11,
+			vtab_le = 1 << 12,
+			vtab_rowid = 1 << 13,
+		};
+
+		/// C++ data exposed as table: tuple of column refs with same row count plus indexes
+		template <class ... Columns>
+		class vtab_source
+		{
+			typedef std::index_sequence_for<Columns...> indexes;
+			typedef void (* column_fn)(const vtab_source &, std::size_t row, sqlite3_context * ctx);
+			typedef void (* narrow_fn)(const vtab_source &, const std::size_t * perm, std::size_t & lo, std::size_t & hi, int op, sqlite3_value * value);
+			typedef void (* build_fn)(vtab_source &, int col, bool sorted);
+
+		public:
+			static constexpr int column_count = sizeof...(Columns);
+
+			enum index_kind : char { no_index, sorted_index, permutation_index };
+
+			std::tuple<Columns...> columns;
+			std::size_t rows = 0;
+			std::string schema;
+			std::array<index_kind, sizeof...(Columns)> index_kinds = {};
+			std::array<std::vector<std::size_t>, sizeof...(Columns)> perms;
+			std::array<double, sizeof...(Columns)> eq_rows = {};   // average rows per distinct value of indexed column
+
+		private:
+			template <std::size_t I>
+			static void column_result(const vtab_source & src, std::size_t row, sqlite3_context * ctx)
+			{
+				const auto & col = std::get<I>(src.columns);
+				typedef typename std::tuple_element_t<I, std::tuple<Columns...>>::value_type Type;
+
+				// data outlives statement, strings and blobs are not copied
+				convert::ibind b(ctx, true);
+				convert::conv<Type>::put(col.get(row), false, b);
+			}
+
+			template <std::size_t I>
+			static void narrow(const vtab_source & src, const std::size_t * perm, std::size_t & lo, std::size_t & hi, int op, sqlite3_value * value)
+			{
+				typedef typename std::tuple_element_t<I, std::tuple<Columns...>>::value_type Type;
+				if constexpr (vtab_indexable<Type>)
+				{
+					const auto & col = std::get<I>(src.columns);
+					decltype(vtab_key(std::declval<const Type &>())) key {};
+					if (!vtab_value_key<Type>(value, key)) return;
+
+					auto at = [&](std::size_t pos) { return vtab_key(col.get(perm ? perm[pos] : pos)); };
+					auto less    = [&](std::size_t pos) { return vtab_less(at(pos), key); };
+					auto less_eq = [&](std::size_t pos) { return !vtab_less(key, at(pos)); };
+
+					switch (op)
+					{
+						case vtab_eq: lo = vtab_partition_point(lo, hi, less); hi = vtab_partition_point(lo, hi, less_eq); break;
+						case vtab_gt: lo = vtab_partition_point(lo, hi, less_eq); break;
+						case vtab_ge: lo = vtab_partition_point(lo, hi, less);    break;
+						case vtab_lt: hi = vtab_partition_point(lo, hi, less);    break;
+						case vtab_le: hi = vtab_partition_point(lo, hi, less_eq); break;
+					}
+				}
+			}
+
+			template <std::size_t I>
+			static void build_index(vtab_source & src, int, bool sorted)
+			{
+				typedef typename std::tuple_element_t<I, std::tuple<Columns...>>::value_type Type;
+				const auto & col = std::get<I>(src.columns);
+				if constexpr (!vtab_indexable<Type>)
+					throw std::invalid_argument(std::string("vtab: column '") + col.name + "' can't be indexed");
+				else
+				{
+					auto key = [&col](std::size_t row) { return vtab_key(col.get(row)); };
+					auto & perm = src.perms[I];
+					if (sorted)
+						src.index_kinds[I] = sorted_index;
+					else
+					{
+						perm.resize(src.rows);
+						std::iota(perm.begin(), perm.end(), std::size_t(0));
+						std::stable_sort(perm.begin(), perm.end(), [&key](std::size_t r1, std::size_t r2) { return vtab_less(key(r1), key(r2)); });
+						src.index_kinds[I] = permutation_index;
+					}
+
+					std::size_t distinct = src.rows ? 1 : 0;
+					for (std::size_t pos = 1; pos < src.rows; ++pos)
+					{
+						auto prev = key(sorted ? pos - 1 : perm[pos - 1]), cur = key(sorted ? pos : perm[pos]);
+						if (vtab_less(cur, prev))
+							throw std::invalid_argument(std::string("vtab: data is not sorted by '") + col.name + "'");
+
+						distinct += vtab_less(prev, cur);
+					}
+
+					src.eq_rows[I] = distinct ? static_cast<double>(src.rows) / distinct : 1;
+				}
+			}
+
+			template <std::size_t ... Is>
+			static constexpr std::array<column_fn, sizeof...(Is)> make_column_fns(std::index_sequence<Is...>) { return {{&column_result<Is>...}}; }
+
+			template <std::size_t ... Is>
+			static constexpr std::array<narrow_fn, sizeof...(Is)> make_narrow_fns(std::index_sequence<Is...>) { return {{&narrow<Is>...}}; }
+
+			template <std::size_t ... Is>
+			static constexpr std::array<build_fn, sizeof...(Is)> make_build_fns(std::index_sequence<Is...>) { return {{&build_index<Is>...}}; }
+
+			static constexpr std::array<column_fn, sizeof...(Columns)> column_fns = make_column_fns(indexes());
+			static constexpr std::array<narrow_fn, sizeof...(Columns)> narrow_fns = make_narrow_fns(indexes());
+			static constexpr std::array<build_fn, sizeof...(Columns)> build_fns = make_build_fns(indexes());
+
+			int find_column(const std::string & name) const
+			{
+				int idx = 0, found = -1;
+				std::apply([&](const auto & ... cols) { ((name == cols.name ? found = idx : 0, ++idx), ...); }, columns);
+				if (found == -1)
+					throw std::invalid_argument("vtab: no such column '" + name + "'");
+
+				return found;
+			}
+
+		public:
+			vtab_source(std::tuple<Columns...> columns_, const vtab_options & opts)
+				: columns(std::move(columns_))
+			{
+				rows = std::get<0>(columns).size();
+				std::apply([this](const auto & ... cols)
+				{
+					if (((cols.size() != rows) || ...))
+						throw std::invalid_argument("vtab: columns have different sizes");
+				}, columns);
+
+				schema = "create table x(";
+				std::apply([this](const auto & ... cols)
+				{
+					bool first = true;
+					auto append = [this, &first](const char * name, const char * type)
+					{
+						if (!first) schema += ", ";
+						first = false;
+
+						schema += '"';
+						for (; *name; ++name)
+						{
+							if (*name == '"') schema += '"';
+							schema += *name;
+						}
+						schema += "\" ";
+						schema += type;
+					};
+
+					(append(cols.name, vtab_column_type<typename std::decay_t<decltype(cols)>::value_type>()), ...);
+				}, columns);
+				schema += ')';
+
+				if (!opts.sorted_by.empty())
+				{
+					int col = find_column(opts.sorted_by);
+					build_fns[col](*this, col, true);
+				}
+
+				for (auto & name : opts.indexed)
+				{
+					int col = find_column(name);
+					if (index_kinds[col] == no_index)
+						build_fns[col](*this, col, false);
+				}
+			}
+
+			const std::size_t * permutation(int col) const noexcept
+			{
+				return index_kinds[col] == permutation_index ? perms[col].data() : nullptr;
+			}
+
+			void column(int col, std::size_t row, sqlite3_context * ctx) const
+			{
+				column_fns[col](*this, row, ctx);
+			}
+
+			void narrow(int col, std::size_t & lo, std::size_t & hi, int op, sqlite3_value * value) const
+			{
+				narrow_fns[col](*this, permutation(col), lo, hi, op, value);
+			}
+		};
+
+		/// eponymous-only module over vtab_source, table has module name and exists in every schema of connection
+		template <class Source>
+		struct vtab_module
+		{
+			struct table : sqlite3_vtab
+			{
+				const Source * source;
+			};
+
+			struct cursor : sqlite3_vtab_cursor
+			{
+				const Source * source;
+				const std::size_t * perm;   // rows in index order, null - natural order
+				std::size_t pos, end;
+
+				std::size_t row() const noexcept { return perm ? perm[pos] : pos; }
+			};
+
+			static int connect(sqlite3 * db, void * aux, int, const char * const *, sqlite3_vtab ** out, char **)
+			{
+				auto * source = static_cast<const Source *>(aux);
+				int res = sqlite3_declare_vtab(db, source->schema.c_str());
+				if (res != SQLITE_OK) return res;
+
+				auto * tbl = new (std::nothrow) table();
+				if (!tbl) return SQLITE_NOMEM;
+
+				tbl->source = source;
+				*out = tbl;
+				return SQLITE_OK;
+			}
+
+			static int disconnect(sqlite3_vtab * vtab)
+			{
+				delete static_cast<table *>(vtab);
+				return SQLITE_OK;
+			}
+
+			static bool collation_binary(sqlite3_index_info * info, int idx)
+			{
+#if SQLITE_VERSION_NUMBER >= 3022000
+				const char * coll = sqlite3_vtab_collation(info, idx);
+				return !coll || sqlite3_stricmp(coll, "BINARY") == 0;
+#else
+				(void)info; (void)idx;
+				return true;
+#endif
+			}
+
+			/// chooses one indexed column: equality is preferred over range, range with both bounds over one bound.
+			/// used constraints are not omitted - sqlite rechecks them, narrowing only have to return superset
+			static int best_index(sqlite3_vtab * vtab, sqlite3_index_info * info)
+			{
+				auto & src = *static_cast<table *>(vtab)->source;
+				double rows = static_cast<double>(src.rows);
+
+				// constraint index per column and kind: eq, lower, upper
+				struct candidate { int eq = -1, lower = -1, upper = -1; };
+				std::array<candidate, Source::column_count> cands;
+				int rowid_eq = -1;
+
+				for (int i = 0; i < info->nConstraint; ++i)
+				{
+					auto & cons = info->aConstraint[i];
+					if (!cons.usable) continue;
+
+					if (cons.iColumn == -1)
+					{
+						if (cons.op == SQLITE_INDEX_CONSTRAINT_EQ) rowid_eq = i;
+						continue;
+					}
+
+					if (src.index_kinds[cons.iColumn] == Source::no_index || !collation_binary(info, i))
+						continue;
+
+					auto & cand = cands[cons.iColumn];
+					switch (cons.op)
+					{
+						case SQLITE_INDEX_CONSTRAINT_EQ: cand.eq = i; break;
+						case SQLITE_INDEX_CONSTRAINT_GT:
+						case SQLITE_INDEX_CONSTRAINT_GE: cand.lower = i; break;
+						case SQLITE_INDEX_CONSTRAINT_LT:
+						case SQLITE_INDEX_CONSTRAINT_LE: cand.upper = i; break;
+					}
+				}
+
+				if (rowid_eq >= 0)
+				{
+					info->idxNum = vtab_rowid;
+					info->aConstraintUsage[rowid_eq].argvIndex = 1;
+					info->aConstraintUsage[rowid_eq].omit = 1;
+					info->estimatedCost = 1;
+					info->estimatedRows = 1;
+					info->idxFlags = SQLITE_INDEX_SCAN_UNIQUE;
+					return SQLITE_OK;
+				}
+
+				int best = -1, best_score = 0;
+				for (int col = 0; col < Source::column_count; ++col)
+				{
+					auto & cand = cands[col];
+					int score = cand.eq >= 0 ? 3 : (cand.lower >= 0) + (cand.upper >= 0);
+					if (score > best_score) best = col, best_score = score;
+				}
+
+				// without constraints index still can give requested order
+				int order_col = info->nOrderBy == 1 && !info->aOrderBy[0].desc ? info->aOrderBy[0].iColumn : -1;
+				if (best == -1 && order_col >= 0 && src.index_kinds[order_col] != Source::no_index)
+					best = order_col;
+
+				double log_rows = std::log2(rows + 1) + 1;
+				if (best == -1)
+				{
+					info->idxNum = 0;
+					info->estimatedCost = rows + 1;
+					info->estimatedRows = static_cast<sqlite3_int64>(rows);
+					return SQLITE_OK;
+				}
+
+				int argv = 0, idxNum = best + 1;
+				auto use = [&](int cons, int kind)
+				{
+					if (cons < 0) return;
+					info->aConstraintUsage[cons].argvIndex = ++argv;
+					idxNum |= kind;
+				};
+
+				auto op_kind = [info](int cons)
+				{
+					switch (info->aConstraint[cons].op)
+					{
+						case SQLITE_INDEX_CONSTRAINT_GT: return int(vtab_gt);
+						case SQLITE_INDEX_CONSTRAINT_GE: return int(vtab_ge);
+						case SQLITE_INDEX_CONSTRAINT_LT: return int(vtab_lt);
+						default:                         return int(vtab_le);
+					}
+				};
+
+				auto & cand = cands[best];
+				double est;
+				if (cand.eq >= 0)
+				{
+					use(cand.eq, vtab_eq);
+					est = src.eq_rows[best];
+				}
+				else
+				{
+					if (cand.lower >= 0) use(cand.lower, op_kind(cand.lower));
+					if (cand.upper >= 0) use(cand.upper, op_kind(cand.upper));
+					est = argv == 2 ? rows / 8 : argv == 1 ? rows / 4 : rows;
+				}
+
+				info->idxNum = idxNum;
+				info->orderByConsumed = order_col == best;
+				info->estimatedCost = log_rows + est;
+				info->estimatedRows = static_cast<sqlite3_int64>(est);
+				return SQLITE_OK;
+			}
+
+			static int open(sqlite3_vtab * vtab, sqlite3_vtab_cursor ** out)
+			{
+				auto * cur = new (std::nothrow) cursor();
+				if (!cur) return SQLITE_NOMEM;
+
+				cur->source = static_cast<table *>(vtab)->source;
+				*out = cur;
+				return SQLITE_OK;
+			}
+
+			static int close(sqlite3_vtab_cursor * cur)
+			{
+				delete static_cast<cursor *>(cur);
+				return SQLITE_OK;
+			}
+
+			static int filter(sqlite3_vtab_cursor * vcur, int idxNum, const char *, int argc, sqlite3_value ** argv)
+			{
+				auto & cur = *static_cast<cursor *>(vcur);
+				auto & src = *cur.source;
+				cur.perm = nullptr;
+				cur.pos = 0;
+				cur.end = src.rows;
+
+				if (idxNum & vtab_rowid)
+				{
+					// constraint is omitted: value must be matched as sqlite compares it, 2.0 is same as 2
+					bool found = false;
+					std::size_t row = 0;
+					switch (sqlite3_value_numeric_type(argv[0]))
+					{
+						case SQLITE_INTEGER:
+						{
+							sqlite3_int64 rowid = sqlite3_value_int64(argv[0]);
+							found = rowid >= 0 && static_cast<std::size_t>(rowid) < src.rows;
+							row = static_cast<std::size_t>(rowid);
+							break;
+						}
+						case SQLITE_FLOAT:
+						{
+							double rowid = sqlite3_value_double(argv[0]);
+							found = rowid >= 0 && rowid < static_cast<double>(src.rows) && rowid == std::floor(rowid);
+							row = found ? static_cast<std::size_t>(rowid) : 0;
+							break;
+						}
+					}
+
+					cur.pos = found ? row : 0;
+					cur.end = found ? cur.pos + 1 : 0;
+					return SQLITE_OK;
+				}
+
+				int col = (idxNum & 0xff) - 1;
+				if (col < 0) return SQLITE_OK;
+
+				cur.perm = src.permutation(col);
+				int arg = 0;
+				for (int kind : {int(vtab_eq), int(vtab_gt), int(vtab_ge), int(vtab_lt), int(vtab_le)})
+					if ((idxNum & kind) && arg < argc)
+						src.narrow(col, cur.pos, cur.end, kind, argv[arg++]);
+
+				return SQLITE_OK;
+			}
+
+			static int next(sqlite3_vtab_cursor * cur)
+			{
+				++static_cast<cursor *>(cur)->pos;
+				return SQLITE_OK;
+			}
+
+			static int eof(sqlite3_vtab_cursor * vcur)
+			{
+				auto & cur = *static_cast<cursor *>(vcur);
+				return cur.pos >= cur.end;
+			}
+
+			static int column(sqlite3_vtab_cursor * vcur, sqlite3_context * ctx, int col)
+			{
+				auto & cur = *static_cast<cursor *>(vcur);
+				try
+				{
+					cur.source->column(col, cur.row(), ctx);
+				}
+				catch (std::bad_alloc &)
+				{
+					sqlite3_result_error_nomem(ctx);
+				}
+				catch (std::exception & ex)
+				{
+					sqlite3_result_error(ctx, ex.what(), -1);
+				}
+
+				return SQLITE_OK;
+			}
+
+			static int rowid(sqlite3_vtab_cursor * vcur, sqlite3_int64 * out)
+			{
+				*out = static_cast<sqlite3_int64>(static_cast<cursor *>(vcur)->row());
+				return SQLITE_OK;
+			}
+
+			static sqlite3_module make_module() noexcept
+			{
+				sqlite3_module mod;
+				std::memset(&mod, 0, sizeof(mod));
+				mod.iVersion = 1;
+				mod.xCreate = nullptr;  // eponymous-only
+				mod.xConnect = &connect;
+				mod.xBestIndex = &best_index;
+				mod.xDisconnect = &disconnect;
+				mod.xDestroy = &disconnect;
+				mod.xOpen = &open;
+				mod.xClose = &close;
+				mod.xFilter = &filter;
+				mod.xNext = &next;
+				mod.xEof = &eof;
+				mod.xColumn = &column;
+				mod.xRowid = &rowid;
+				return mod;
+			}
+
+			static void destroy_source(void * ptr) noexcept
+			{
+				delete static_cast<Source *>(ptr);
+			}
+
+			inline static const sqlite3_module module = make_module();
+		};
+
+		template <class ... Columns>
+		void create_vtab(session & ses, const char * name, std::tuple<Columns...> columns, const vtab_options & opts)
+		{
+			typedef vtab_source<Columns...> source;
+			typedef vtab_module<source> module;
+
+			auto * src = new source(std::move(columns), opts);
+			// on failure sqlite calls destroy itself
+			int res = sqlite3_create_module_v2(ses.native(), name, &module::module, src, &module::destroy_source);
+			if (res != SQLITE_OK)
+				throw sqlite_exterror(res, ses.native());
+		}
+	}
+
+	/// column of column store table, see create_column_table
+	template <class Container>
+	detail::container_column_ref<Container> table_column(const char * name, const Container & data)
+	{
+		return {name, &data};
+	}
+
+	/// exposes random access range of records, described by record_traits<Record>, as read-only virtual table name.
+	/// rows are not copied: columns are read from range on demand, strings and blobs are returned without copying,
+	/// rowid is position in range. table is eponymous - used by module name directly, without CREATE VIRTUAL TABLE:
+	///   create_range_table(ses, "people", people, {{"name"}});  select * from people p join orders o on o.person = p.id
+	///
+	/// range must outlive registration(session or re-registration with same name) and must not be modified,
+	/// register again to pick up changes - indexes are built at registration.
+	template <class Range>
+	void create_range_table(session & ses, const char * name, const Range & rows, const vtab_options & opts = {})
+	{
+		typedef std::decay_t<decltype(*std::begin(rows))> Record;
+		static_assert(has_record_traits<Record>::value, "record_traits<Record> is not specialized");
+
+		auto columns = std::apply([&rows](const auto & ... cols)
+		{
+			return std::make_tuple(detail::record_column_ref<Range, Record, typename std::decay_t<decltype(cols)>::value_type>
+				{cols.name, &rows, cols.member}...);
+		}, record_traits<Record>::columns);
+
+		detail::create_vtab(ses, name, std::move(columns), opts);
+	}
+
+	/// exposes column store - random access containers of same size, see table_column - as read-only virtual table name.
+	/// same rules as for create_range_table apply:
+	///   create_column_table(ses, "prices", {{}, "ts"}, table_column("ts", ts), table_column("price", price));
+	template <class ... Containers>
+	void create_column_table(session & ses, const char * name, const vtab_options & opts, detail::container_column_ref<Containers> ... columns)
+	{
+		static_assert(sizeof...(Containers) > 0, "table must have columns");
+		detail::create_vtab(ses, name, std::make_tuple(columns...), opts);
+	}
+}
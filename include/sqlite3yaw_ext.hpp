@@ -1,4 +1,9 @@
 #include <sqlite3yaw_ext/table_meta.hpp>
+#include <sqlite3yaw_ext/pooled_table_meta.hpp>
+#include <sqlite3yaw_ext/meta_cache.hpp>
 #include <sqlite3yaw_ext/util.hpp>
 #include <sqlite3yaw_ext/batch.hpp>
-#include <sqlite3yaw_ext/record_range.hpp>
\ No newline at end of file
+#include <sqlite3yaw_ext/static_command.hpp>
+#include <sqlite3yaw_ext/record_range.hpp>
+#include <sqlite3yaw_ext/delimited_loader.hpp>
+#include <sqlite3yaw_ext/arrow.hpp>
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sqlite3yaw/session.hpp>
+#include <sqlite3yaw/statement.hpp>
+#include <sqlite3yaw/column_batch.hpp>
+
+// Apache Arrow C data interface ABI, see https://arrow.apache.org/docs/format/CDataInterface.html
+// and https://arrow.apache.org/docs/format/CStreamInterface.html.
+// guarded by same macros as arrow/c/abi.h, so arrow headers can be included along
+extern "C"
+{
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+	struct ArrowSchema
+	{
+		// Array type description
+		const char * format;
+		const char * name;
+		const char * metadata;
+		int64_t flags;
+		int64_t n_children;
+		struct ArrowSchema ** children;
+		struct ArrowSchema * dictionary;
+
+		// Release callback
+		void (* release)(struct ArrowSchema *);
+		// Opaque producer-specific data
+		void * private_data;
+	};
+
+	struct ArrowArray
+	{
+		// Array data description
+		int64_t length;
+		int64_t null_count;
+		int64_t offset;
+		int64_t n_buffers;
+		int64_t n_children;
+		const void ** buffers;
+		struct ArrowArray ** children;
+		struct ArrowArray * dictionary;
+
+		// Release callback
+		void (* release)(struct ArrowArray *);
+		// Opaque producer-specific data
+		void * private_data;
+	};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+	struct ArrowArrayStream
+	{
+		int (* get_schema)(struct ArrowArrayStream *, struct ArrowSchema * out);
+		int (* get_next)(struct ArrowArrayStream *, struct ArrowArray * out);
+		const char * (* get_last_error)(struct ArrowArrayStream *);
+
+		// Release callback
+		void (* release)(struct ArrowArrayStream *);
+		// Opaque producer-specific data
+		void * private_data;
+	};
+
+#endif  // ARROW_C_STREAM_INTERFACE
+}
+
+namespace sqlite3yaw
+{
+	/// query results as Arrow record batches: struct("+s") of nullable columns, one per result column.
+	/// column types come from column_batch: INTEGER - int64("l"), FLOAT - float64("g"), TEXT - utf8("u"), BLOB - binary("z").
+	/// column without known type(all values of first batch are NULL) is exported as utf8,
+	/// and is fixed to TEXT for following batches, so all batches have same schema.
+	/// no Arrow library is needed, consumer takes ownership and calls release.
+
+	/// fills schema of batch columns
+	void export_arrow_schema(const column_batch & batch, ArrowSchema * out);
+	/// moves batch data into out without copying, batch is left empty with same columns.
+	/// next fetch_batch allocates new buffers
+	void export_arrow_array(column_batch & batch, ArrowArray * out);
+
+	/// exports results of stmt as stream of record batches up to batch_rows rows each.
+	/// first batch is fetched by get_schema(or first get_next) to refine column types.
+	/// if column type changes in later batch(INTEGER promoted to FLOAT by REAL value of NUMERIC column or expression)
+	/// get_next fails with EIO, values are not truncated: cast such column in query or use larger batch_rows.
+	/// stream references stmt: statement must outlive stream and must not be used while stream is in use.
+	/// errors are reported by get_next/get_schema codes(EIO, ENOMEM) and get_last_error
+	void export_arrow_stream(statement & stmt, ArrowArrayStream * out, std::size_t batch_rows = 64 * 1024);
+
+	/// inserts rows of Arrow record batch(struct array) through stmt: column i is bound to parameter i + 1,
+	/// statement must have exactly as many parameters as batch has columns. values are bound without copying.
+	/// supported formats: n, b, c, C, s, S, i, I, l, L, f, g, u, U, z, Z, tdD, tdm, ts*, tt*, tD*(as integers).
+	/// run it inside transaction. returns number of inserted rows
+	std::size_t insert_arrow(statement & stmt, const ArrowSchema & schema, const ArrowArray & array);
+	/// inserts record batch into table, columns are named by batch schema field names.
+	/// statement is prepared via session::prepare_cached
+	std::size_t insert_arrow(session & ses, const std::string & table, const ArrowSchema & schema, const ArrowArray & array);
+}
@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -46,7 +48,7 @@ namespace sqlite3yaw
 			typedef bool result_type;
 			result_type operator()(const CharRangeVec & v1, const CharRangeVec & v2) const
 			{
-				return boost::range::equal(v1, v2, ext::ctpred::less<metastr_traits>());
+				return boost::range::equal(v1, v2, ext::ctpred::equal_to<metastr_traits>());
 			}
 		};
 
@@ -70,9 +72,9 @@ namespace sqlite3yaw
 		}
 
 		BOOST_NORETURN inline
-		void ThrowRecordHasNoPk()
+		void ThrowRecordHasNoPk(const std::string & pk)
 		{
-			throw std::runtime_error("batch_upsert: record missing pk");
+			throw std::runtime_error("batch_upsert: record missing pk field " + pk);
 		}
 
 		BOOST_NORETURN inline
@@ -83,47 +85,119 @@ namespace sqlite3yaw
 			throw std::runtime_error(err);
 		}
 
+		/// insert ... on conflict do update is supported since sqlite 3.24.0
+		inline bool native_upsert_supported() noexcept
+		{
+			return sqlite3_libversion_number() >= 3024000;
+		}
+
+		/// positions of key columns in record, in key order
+		typedef std::vector<int> KeyPositions;
+
 		struct CacheItem
 		{
-			statement stmt;
-			int       pkPos;
+			statement    stmt;
+			KeyPositions keyPos;
 
-			CacheItem(statement && stmt_, int pkPos_) : stmt(std::move(stmt_)), pkPos(pkPos_) {}
-			CacheItem(CacheItem && r) : stmt(std::move(r.stmt)), pkPos(r.pkPos) {}
+			CacheItem(statement && stmt_, KeyPositions keyPos_) : stmt(std::move(stmt_)), keyPos(std::move(keyPos_)) {}
+			CacheItem(CacheItem && r) : stmt(std::move(r.stmt)), keyPos(std::move(r.keyPos)) {}
 
 			friend void swap(CacheItem & ci1, CacheItem & ci2)
-			{ swap(ci1.stmt, ci2.stmt); std::swap(ci1.pkPos, ci2.pkPos); }
+			{ swap(ci1.stmt, ci2.stmt); ci1.keyPos.swap(ci2.keyPos); }
 		};
 
+		/// finds positions of pk columns in record field names, throws if some is missing
+		inline KeyPositions find_key_positions(const CharRangeVec & fieldNames, const std::vector<std::string> & pk)
+		{
+			ext::ctpred::equal_to<metastr_traits> eq;
+			KeyPositions keyPos;
+			keyPos.reserve(pk.size());
+
+			for (auto & key : pk)
+			{
+				auto it = boost::find_if(fieldNames, [&eq, &key](const CharRange & name) { return eq(key, name); });
+				if (it == fieldNames.end())
+					ThrowRecordHasNoPk(key);
+
+				keyPos.push_back(static_cast<int>(it - fieldNames.begin()));
+			}
+
+			return keyPos;
+		}
+
 
 		template <class RandomAccessIterator>
-		void bind_helper_ll(statement & stmt, RandomAccessIterator first, RandomAccessIterator last, int keyIdx, std::random_access_iterator_tag)
+		void bind_helper_ll(statement & stmt, RandomAccessIterator first, RandomAccessIterator last, const KeyPositions & keyPos, std::random_access_iterator_tag)
 		{
-			bind(stmt, stmt.bind_parameter_count(), *(first + keyIdx));
+			int keyIdx = stmt.bind_parameter_count() - static_cast<int>(keyPos.size());
+			for (int pos : keyPos)
+				bind(stmt, ++keyIdx, *(first + pos));
+
 			for (int idx = 0; first != last; ++first)
 				bind(stmt, ++idx, *first);
 		}
 
 		template <class SinglePassIterator>
-		void bind_helper_ll(statement & stmt, SinglePassIterator first, SinglePassIterator last, int keyIdx, std::input_iterator_tag)
+		void bind_helper_ll(statement & stmt, SinglePassIterator first, SinglePassIterator last, const KeyPositions & keyPos, std::input_iterator_tag)
 		{
+			const int keyBase = stmt.bind_parameter_count() - static_cast<int>(keyPos.size());
 			for (int idx = 0; first != last; ++first)
 			{
-				if (idx == keyIdx)
-					bind(stmt, stmt.bind_parameter_count(), *first);
+				for (std::size_t k = 0; k < keyPos.size(); ++k)
+					if (keyPos[k] == idx)
+						bind(stmt, keyBase + static_cast<int>(k + 1), *first);
+
 				bind(stmt, ++idx, *first);
 			}
 		}
 
+		/// upper bound of automatically chosen rows per statement for batch_insert_multirow,
+		/// statements with thousands of rows are expensive to prepare and bind.
+		/// sqlite3yaw-bench batch_insert_multirow/10000/rows_N sweeps this value
+		const std::size_t MultirowAutoMaxRows = 64;
+
+		/// sorted(by metastr_traits) list of table fields, used by batch_insert* to find binding index of field
+		inline CharRangeVec sorted_fields(const table_meta & meta)
+		{
+			CharRangeVec fields;
+			fields.reserve(meta.fields.size());
+			for (auto & f : meta.fields)
+				fields.push_back(MakeCharRange(f.name));
+
+			boost::sort(fields, ext::ctpred::less<metastr_traits>());
+			return fields;
+		}
+
+		/// binds record values to stmt, binding index is position of field name in fields + offset + 1
+		template <class Record>
+		void bind_record(statement & stmt, const Record & rec, const CharRangeVec & fields, int offset)
+		{
+			ext::ctpred::less<metastr_traits> less;
+			for (auto && valPair : rec)
+			{
+				using std::get;
+				auto fname = MakeCharRange(get<0>(valPair));
+
+				auto pos = ext::binary_find(fields.begin(), fields.end(), fname, less)
+				           - fields.begin();
+
+				if (static_cast<std::size_t>(pos) == fields.size())
+					ThrowUnknownField(fname);
+
+				sqlite3yaw::bind(stmt, offset + static_cast<int>(pos + 1), get<1>(std::forward<decltype(valPair)>(valPair)));
+			}
+		}
+
 		/// helper function
 		/// it binds values from range to a statement like
-		/// "update test set f1 = ? ... set kf = ? ... where kf = ?"
+		/// "update test set f1 = ? ... set kf1 = ? ... where kf1 = ? and kf2 = ?",
+		/// keyPos - positions of key values in range, in order of where clause
 		template <class Range>
-		void bind_helper(statement & stmt, const Range & rng, int keyIdx)
+		void bind_helper(statement & stmt, const Range & rng, const KeyPositions & keyPos)
 		{
 			typedef typename boost::range_iterator<Range>::type iterator;
 			typedef typename boost::iterator_category<iterator>::type category;
-			bind_helper_ll(stmt, boost::begin(rng), boost::end(rng), keyIdx, category());
+			bind_helper_ll(stmt, boost::begin(rng), boost::end(rng), keyPos, category());
 		}
 	}
 	
@@ -134,45 +208,81 @@ namespace sqlite3yaw
 	void batch_insert(const ForwardRange & records, session & ses, const table_meta & meta)
 	{
 		using namespace detail;
-		CharRangeVec fields;
-		fields.reserve(meta.fields.size());
-		for (auto & f : meta.fields)
-			fields.push_back(MakeCharRange(f.name));
-
-		ext::ctpred::less<metastr_traits> less;
-		boost::sort(fields, less);
-		auto cmd = insert_command(meta.table_name, fields);
-		auto stmt = ses.prepare(cmd);
+		auto fields = sorted_fields(meta);
+		auto lease = ses.prepare_cached(insert_command(meta.table_name, fields));
+		auto & stmt = *lease;
 
 		for (const auto & rec : records)
 		{
-			for (auto && valPair : rec)
-			{
-				using std::get;
-				auto fname = MakeCharRange(get<0>(valPair));
-
-				auto pos = ext::binary_find(fields.begin(), fields.end(), fname, less)
-				           - fields.begin();
-
-				if (pos == fields.size())
-					ThrowUnknownField(fname);
-
-				sqlite3yaw::bind(stmt, static_cast<int>(pos + 1), get<1>(std::forward<decltype(valPair)>(valPair)));
-			}
+			bind_record(stmt, rec, fields, 0);
 
 			stmt.step();
 			stmt.reset();
 			stmt.clear_bindings();
 		}
+	}
+
+	/// same as batch_insert, but packs up to rows_per_statement records into one
+	/// insert into t(...) values (?,?), (?,?), ... statement, so sqlite executes statement once per chunk.
+	/// if rows_per_statement is 0 - it's chosen by SQLITE_LIMIT_VARIABLE_NUMBER of session,
+	/// but not more than detail::MultirowAutoMaxRows: huge statements are expensive to prepare and bind.
+	/// explicit rows_per_statement is clamped to SQLITE_LIMIT_VARIABLE_NUMBER too.
+	/// last partial chunk is inserted by it's own statement.
+	template <class ForwardRange>
+	void batch_insert_multirow(const ForwardRange & records, session & ses, const table_meta & meta,
+	                           std::size_t rows_per_statement = 0)
+	{
+		using namespace detail;
+		auto fields = sorted_fields(meta);
+		if (fields.empty())
+			throw std::invalid_argument("batch_insert_multirow: table " + meta.table_name + " has no fields");
+
+		const int ncols = static_cast<int>(fields.size());
+		const std::size_t maxrows = std::max(1, ses.limit(SQLITE_LIMIT_VARIABLE_NUMBER, -1) / ncols);
+		if (rows_per_statement == 0)
+			rows_per_statement = std::min<std::size_t>(MultirowAutoMaxRows, maxrows);
+		else
+			rows_per_statement = std::min(rows_per_statement, maxrows);
+
+		auto first = boost::begin(records);
+		auto last = boost::end(records);
+		const auto count = static_cast<std::size_t>(std::distance(first, last));
+		const std::size_t nchunks = count / rows_per_statement;
+		const std::size_t tail_rows = count % rows_per_statement;
+
+		if (nchunks != 0)
+		{
+			auto lease = ses.prepare_cached(insert_command(meta.table_name, fields, rows_per_statement));
+			auto & stmt = *lease;
+
+			for (std::size_t chunk = 0; chunk < nchunks; ++chunk)
+			{
+				for (std::size_t row = 0; row < rows_per_statement; ++row, ++first)
+					bind_record(stmt, *first, fields, static_cast<int>(row) * ncols);
+
+				stmt.step();
+				stmt.reset();
+				stmt.clear_bindings();
+			}
+		}
+
+		if (tail_rows == 0) return;
 
-		stmt.finalize();
+		auto tail = ses.prepare_cached(insert_command(meta.table_name, fields, tail_rows));
+		for (std::size_t row = 0; first != last; ++first, ++row)
+			bind_record(*tail, *first, fields, static_cast<int>(row) * ncols);
+
+		tail->step();
 	}
 
 	/// upserts records into table described by meta
 	/// record is a range of pair or pair like type. It accessed throw std::get<0>/std::get<1>,
 	/// expression std::get<0/1>(*records.begin().begin()) must be valid
 	/// 
-	/// upsert means try update, if no such record - insert
+	/// upsert means try update, if no such record - insert.
+	/// key is meta.primary_key, composite keys are supported(including WITHOUT ROWID tables), record must contain all key fields.
+	/// if runtime sqlite supports it(3.24+) - one native insert ... on conflict(pk, ...) do update statement is used per field set,
+	/// otherwise update is executed and, if nothing was changed, - insert
 	///
 	/// IMPL NOTE: each record in records traversed twice(so if you use some transforming iterator, you may be better buffer it)
 	template <class ForwardRange>
@@ -184,16 +294,17 @@ namespace sqlite3yaw
 			CharPtrRangeVecHasher, CharPtrRangeVecEqual
 		> cache_type;
 
-		if (meta.pk.empty())
+		const auto pk = primary_key_columns(meta);
+		if (pk.empty())
 			ThrowNoPrimaryKey(meta);
 
-		auto isPk = boost::bind(ext::ctpred::equal_to<metastr_traits>(), boost::cref(meta.pk), _1);
 		// moved outside for performance
 		// vector will not realloc each iteration
 		CharRangeVec curFieldNames;
 		curFieldNames.reserve(meta.fields.size());
 
 		cache_type cache(500);
+		const bool native = native_upsert_supported();
 
 		for (const auto & rec : records)
 		{
@@ -203,26 +314,31 @@ namespace sqlite3yaw
 			auto * item = cache.find_ptr(curFieldNames);
 			if (!item) // create new command
 			{
-				auto pk = boost::find_if(curFieldNames, isPk);
-				if (pk == curFieldNames.end())
-					ThrowRecordHasNoPk();
-
-				int pkPos = static_cast<int>(pk - curFieldNames.begin());
-				auto new_stmt = ses.prepare(update_command(meta.table_name, curFieldNames, *pk));
-				item = &cache.insert(curFieldNames, CacheItem(std::move(new_stmt), pkPos));
+				auto keyPos = find_key_positions(curFieldNames, pk);
+				auto cmd = native ? upsert_command(meta.table_name, curFieldNames, pk)
+				                  : update_command(meta.table_name, curFieldNames, pk);
+				item = &cache.insert(curFieldNames, CacheItem(ses.prepare(cmd), std::move(keyPos)));
 			}
 
 			auto & stmt = item->stmt;
-			// bind both values and where <pk> = ?
-			detail::bind_helper(stmt, rec | ext::seconds, item->pkPos);
-			stmt.step();
-
-			if (!ses.changes()) // no such records - insert
+			if (native)
 			{
-				auto stmt = ses.prepare(insert_command(meta.table_name, curFieldNames));
 				boost::for_each(rec | ext::seconds, auto_binder(stmt));
 				stmt.step();
 			}
+			else
+			{
+				// bind both values and where <pk> = ? and ...
+				detail::bind_helper(stmt, rec | ext::seconds, item->keyPos);
+				stmt.step();
+			}
+
+			if (!native && !ses.changes()) // no such records - insert
+			{
+				auto stmt = ses.prepare_cached(insert_command(meta.table_name, curFieldNames));
+				boost::for_each(rec | ext::seconds, auto_binder(*stmt));
+				stmt->step();
+			}
 
 			// clear command for reuse from cache
 			stmt.reset();
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <sqlite3yaw/session.hpp>
+#include <sqlite3yaw_ext/table_meta.hpp>
+
+namespace sqlite3yaw
+{
+	struct delimited_load_options
+	{
+		char delimiter = ',';             /// field delimiter, '\t' for TSV
+		char quote = '"';                 /// quote char, '\0' - fields are never quoted(TSV)
+		bool has_header = true;           /// first line holds column names, otherwise meta.fields order is used
+		bool empty_as_null = true;        /// unquoted empty field is bound as null
+		std::size_t chunk_rows = 100000;  /// rows committed in one transaction
+		std::size_t queue_depth = 4;      /// parsed chunks waiting for insertion
+	};
+
+	struct delimited_load_stats
+	{
+		std::uint64_t rows = 0;
+		std::uint64_t bytes = 0;
+		double seconds = 0;
+
+		double rows_per_sec() const  { return seconds > 0 ? rows / seconds : 0; }
+		double bytes_per_sec() const { return seconds > 0 ? bytes / seconds : 0; }
+	};
+
+	/// loads CSV/TSV file into table described by meta.
+	/// file is memory mapped, fields are split in place and bound with SQLITE_STATIC,
+	/// only quoted fields with escaped quotes("") are copied.
+	/// parsing runs on separate thread, while calling thread inserts parsed chunks,
+	/// each chunk is committed in it's own immediate transaction, session should not be in transaction.
+	///
+	/// throws std::runtime_error on malformed input(with line number), sqlite_error on database errors.
+	/// chunks committed before error stay in database.
+	delimited_load_stats load_delimited(session & ses, const table_meta & meta, const std::string & path,
+	                                    const delimited_load_options & opts = {});
+}
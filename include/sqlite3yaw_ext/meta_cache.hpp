@@ -0,0 +1,47 @@
+#pragma once
+#include <map>
+#include <string>
+#include <ext/functors/ctpred.hpp>
+#include <sqlite3yaw/session.hpp>
+#include <sqlite3yaw/statement.hpp>
+#include <sqlite3yaw_ext/table_meta.hpp>
+
+namespace sqlite3yaw
+{
+	/// session scoped cache of table_meta, table names are looked up case-insensitively(metastr_traits).
+	/// only tables of main database are cached: meta is loaded with PRAGMA main.table_info, temp tables shadowing
+	/// main ones and tables of attached databases are not seen(their schema changes don't touch main schema_version).
+	/// on each lookup cache checks PRAGMA main.schema_version(prepared once, reads database header),
+	/// if it changed since last check - all cached entries are dropped and reloaded on demand.
+	/// so sqlite_master is touched only when schema actually changed, by this or any other connection.
+	///
+	/// cache holds reference to session, session must outlive it. not thread safe, same as session.
+	class table_meta_cache
+	{
+		typedef std::map<std::string, table_meta, ext::ctpred::less<metastr_traits>> meta_map;
+
+		session * ses;
+		statement version_stmt;
+		int version = -1;
+		meta_map tables;
+
+	private:
+		int read_schema_version();
+
+	public:
+		explicit table_meta_cache(session & ses);
+
+		/// returns metadata of main.table_name, loading it if not cached or schema changed.
+		/// returned reference is valid until next lookup detects schema change or invalidate call.
+		/// if table does not exist - returned meta has no fields
+		const table_meta & get(const std::string & table_name);
+		/// checks schema_version and drops cached entries if it changed, returns true if it did
+		bool revalidate();
+		/// drops all cached entries
+		void invalidate() noexcept;
+
+		/// schema_version seen on last check, -1 if never checked
+		int schema_version() const noexcept { return version; }
+		std::size_t size() const noexcept { return tables.size(); }
+	};
+}
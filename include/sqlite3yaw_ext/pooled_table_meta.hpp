@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <sqlite3yaw/session_pool.hpp>
+#include <sqlite3yaw_ext/table_meta.hpp>
+
+namespace sqlite3yaw
+{
+	///same as load_session_meta(session &), but tables are spread across threads,
+	///each loading it's share through it's own pool reader. threads = 0 - pool.readers_count()
+	std::vector<table_meta> load_session_meta(session_pool & pool, std::size_t threads = 0, bool with_indexes = false);
+}
@@ -0,0 +1,335 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <sqlite3yaw.hpp>
+#include <sqlite3yaw/record_traits.hpp>
+#include <sqlite3yaw_ext/batch.hpp>
+
+namespace sqlite3yaw
+{
+	/// fixed size null terminated string usable in constant expressions
+	template <std::size_t N>
+	struct fixed_string
+	{
+		char chars[N + 1] = {};
+
+		constexpr std::size_t size() const noexcept { return N; }
+		constexpr const char * c_str() const noexcept { return chars; }
+		constexpr operator std::string_view() const noexcept { return {chars, N}; }
+		std::string str() const { return {chars, N}; }
+	};
+
+	namespace detail
+	{
+		/// first pass of command generation: only counts chars
+		struct command_counter
+		{
+			std::size_t size = 0;
+			constexpr void put(char) { ++size; }
+		};
+
+		/// second pass: writes chars into fixed_string
+		template <std::size_t N>
+		struct command_writer
+		{
+			fixed_string<N> str;
+			std::size_t pos = 0;
+			constexpr void put(char ch) { str.chars[pos++] = ch; }
+		};
+
+		template <class Out>
+		constexpr void put_text(Out & out, const char * text)
+		{
+			for (; *text; ++text) out.put(*text);
+		}
+
+		/// same escaping as escape_sql_name: '"' + name + '"', '"' inside name is doubled
+		template <class Out>
+		constexpr void put_name(Out & out, const char * name)
+		{
+			out.put('"');
+			for (; *name; ++name)
+			{
+				if (*name == '"') out.put('"');
+				out.put(*name);
+			}
+			out.put('"');
+		}
+
+		template <class Record>
+		constexpr std::size_t record_key_count()
+		{
+			std::size_t count = 0;
+			for_each_column<Record>([&count](std::size_t, const auto & col) { count += col.key; });
+			return count;
+		}
+
+		/// generators produce same text as runtime builders from util.hpp,
+		/// so static and runtime commands share session statement cache entries
+
+		/// insert into "t" ( "c1","c2") values ( ?,?), same as custom_insert_command(insert_word, ...)
+		template <class Record, bool OrIgnore = false>
+		struct insert_generator
+		{
+			template <class Out>
+			static constexpr void write(Out & out)
+			{
+				put_text(out, OrIgnore ? "insert or ignore into " : "insert into ");
+				put_name(out, record_traits<Record>::table);
+				put_text(out, " ( ");
+				for_each_column<Record>([&out](std::size_t idx, const auto & col)
+				{
+					if (idx) out.put(',');
+					put_name(out, col.name);
+				});
+
+				put_text(out, ") values ( ");
+				for (std::size_t idx = 0; idx < record_column_count<Record>; ++idx)
+					put_text(out, idx ? ",?" : "?");
+
+				out.put(')');
+			}
+		};
+
+		/// update "t" set "c1" = ?,"c2" = ? where "k1" = ? and "k2" = ?
+		template <class Record>
+		struct update_generator
+		{
+			template <class Out>
+			static constexpr void write(Out & out)
+			{
+				put_text(out, "update ");
+				put_name(out, record_traits<Record>::table);
+				put_text(out, " set ");
+
+				bool first = true;
+				for_each_column<Record>([&out, &first](std::size_t, const auto & col)
+				{
+					if (col.key) return;
+					if (!first) out.put(',');
+					first = false;
+
+					put_name(out, col.name);
+					put_text(out, " = ?");
+				});
+
+				put_text(out, " where ");
+				first = true;
+				for_each_column<Record>([&out, &first](std::size_t, const auto & col)
+				{
+					if (!col.key) return;
+					if (!first) put_text(out, " and ");
+					first = false;
+
+					put_name(out, col.name);
+					put_text(out, " = ?");
+				});
+			}
+		};
+
+		/// insert ... on conflict("k1", "k2") do update set "c1" = excluded."c1", ...
+		template <class Record>
+		struct upsert_generator
+		{
+			template <class Out>
+			static constexpr void write(Out & out)
+			{
+				insert_generator<Record>::write(out);
+				put_text(out, " on conflict(");
+
+				bool first = true;
+				for_each_column<Record>([&out, &first](std::size_t, const auto & col)
+				{
+					if (!col.key) return;
+					if (!first) put_text(out, ", ");
+					first = false;
+					put_name(out, col.name);
+				});
+
+				put_text(out, ") do ");
+				first = true;
+				for_each_column<Record>([&out, &first](std::size_t, const auto & col)
+				{
+					if (col.key) return;
+					put_text(out, first ? "update set " : ", ");
+					first = false;
+
+					put_name(out, col.name);
+					put_text(out, " = excluded.");
+					put_name(out, col.name);
+				});
+
+				if (first) put_text(out, "nothing");
+			}
+		};
+
+		/// select "c1", "c2" from "t"
+		template <class Record>
+		struct select_generator
+		{
+			template <class Out>
+			static constexpr void write(Out & out)
+			{
+				put_text(out, "select ");
+				for_each_column<Record>([&out](std::size_t idx, const auto & col)
+				{
+					if (idx) put_text(out, ", ");
+					put_name(out, col.name);
+				});
+
+				put_text(out, " from ");
+				put_name(out, record_traits<Record>::table);
+			}
+		};
+
+		template <class Generator>
+		constexpr auto generate_command()
+		{
+			constexpr std::size_t size = [] { command_counter counter; Generator::write(counter); return counter.size; }();
+			command_writer<size> writer;
+			Generator::write(writer);
+			return writer.str;
+		}
+
+		template <class Record>
+		constexpr bool check_keyed()
+		{
+			static_assert(has_record_traits<Record>::value, "record_traits<Record> is not specialized");
+			static_assert(record_key_count<Record>() > 0, "record_traits<Record> has no key_column");
+			return true;
+		}
+
+		template <class Record>
+		constexpr bool check_updatable()
+		{
+			check_keyed<Record>();
+			static_assert(record_key_count<Record>() < record_column_count<Record>,
+			              "record_traits<Record> has only key columns, there is nothing to update");
+			return true;
+		}
+
+		/// record without non key columns: update does nothing, upsert is insert or ignore
+		template <class Record>
+		constexpr bool only_keys = record_key_count<Record>() == record_column_count<Record>;
+
+		template <class Record>
+		inline constexpr auto static_insert_or_ignore_command = generate_command<insert_generator<Record, true>>();
+	}
+
+	/// compile time commands generated from record_traits<Record>, fixed_string constants.
+	/// text is same as of insert_command/upsert_command/select_command for same columns.
+	/// update command sets non key columns and selects by key columns: it's same as update_command
+	/// only if that is given just non key columns. record must have non key columns for it.
+	template <class Record>
+	inline constexpr auto static_insert_command = detail::generate_command<detail::insert_generator<Record>>();
+
+	template <class Record>
+	inline constexpr auto static_update_command = (detail::check_updatable<Record>(), detail::generate_command<detail::update_generator<Record>>());
+
+	template <class Record>
+	inline constexpr auto static_upsert_command = (detail::check_keyed<Record>(), detail::generate_command<detail::upsert_generator<Record>>());
+
+	template <class Record>
+	inline constexpr auto static_select_command = detail::generate_command<detail::select_generator<Record>>();
+
+	/// binds rec to statement prepared from static_insert_command or static_upsert_command: columns in declaration order
+	template <class Record>
+	void bind_insert(statement & stmt, const Record & rec)
+	{
+		for_each_column<Record>([&stmt, &rec](std::size_t idx, const auto & col)
+		{
+			bind(stmt, static_cast<int>(idx + 1), rec.*col.member);
+		});
+	}
+
+	/// binds rec to statement prepared from static_update_command: non key columns, then key columns
+	template <class Record>
+	void bind_update(statement & stmt, const Record & rec)
+	{
+		int idx = 0;
+		for_each_column<Record>([&stmt, &rec, &idx](std::size_t, const auto & col)
+		{
+			if (!col.key) bind(stmt, ++idx, rec.*col.member);
+		});
+
+		for_each_column<Record>([&stmt, &rec, &idx](std::size_t, const auto & col)
+		{
+			if (col.key) bind(stmt, ++idx, rec.*col.member);
+		});
+	}
+
+	/// reads current row of statement prepared from static_select_command into rec
+	template <class Record>
+	void get_select(statement & stmt, Record & rec)
+	{
+		for_each_column<Record>([&stmt, &rec](std::size_t idx, const auto & col)
+		{
+			get(stmt, static_cast<int>(idx), rec.*col.member);
+		});
+	}
+
+	/// inserts records with static_insert_command, statement is prepared via session::prepare_cached
+	template <class SinglePassRange>
+	void static_batch_insert(const SinglePassRange & records, session & ses)
+	{
+		typedef std::decay_t<decltype(*boost::begin(records))> Record;
+		auto stmt = ses.prepare_cached(static_insert_command<Record>.c_str());
+
+		for (const auto & rec : records)
+		{
+			bind_insert(*stmt, rec);
+			stmt->step();
+			stmt->reset();
+		}
+	}
+
+	/// upserts records by key columns: native static_upsert_command on sqlite 3.24+,
+	/// otherwise static_update_command and, if nothing was changed, static_insert_command.
+	/// record of only key columns has nothing to update - it's insert or ignore there
+	template <class SinglePassRange>
+	void static_batch_upsert(const SinglePassRange & records, session & ses)
+	{
+		typedef std::decay_t<decltype(*boost::begin(records))> Record;
+		if (detail::native_upsert_supported())
+		{
+			auto stmt = ses.prepare_cached(static_upsert_command<Record>.c_str());
+			for (const auto & rec : records)
+			{
+				bind_insert(*stmt, rec);
+				stmt->step();
+				stmt->reset();
+			}
+
+			return;
+		}
+
+		if constexpr (detail::only_keys<Record>)
+		{
+			auto insert = ses.prepare_cached(detail::static_insert_or_ignore_command<Record>.c_str());
+			for (const auto & rec : records)
+			{
+				bind_insert(*insert, rec);
+				insert->step();
+				insert->reset();
+			}
+		}
+		else
+		{
+			auto update = ses.prepare_cached(static_update_command<Record>.c_str());
+			auto insert = ses.prepare_cached(static_insert_command<Record>.c_str());
+			for (const auto & rec : records)
+			{
+				bind_update(*update, rec);
+				update->step();
+				update->reset();
+				if (ses.changes()) continue;
+
+				bind_insert(*insert, rec);
+				insert->step();
+				insert->reset();
+			}
+		}
+	}
+}
\ No newline at end of file
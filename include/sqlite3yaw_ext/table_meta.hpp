@@ -14,21 +14,41 @@ namespace sqlite3yaw
 		std::string name;
 		std::string type;                      ///sqlite column type as in create table statement
 		std::string def_val;
+		bool notnull = false;
+		int pk_pos = 0;                        ///1-based position of column in primary key, 0 - not part of primary key
+	};
+
+	struct index_meta
+	{
+		std::string name;
+		bool unique = false;
+		bool partial = false;
+		std::string origin;                    ///"c" - create index, "u" - unique constraint, "pk" - primary key
+		std::vector<std::string> columns;      ///indexed columns in index order, expression columns are empty
 	};
 
 	struct table_meta
 	{
 		std::string table_name;
 		std::vector<field_meta> fields;       /// table columns in order of real placement
-		std::string pk;                       /// primary key column name, if missing - empty
+		std::string pk;                       /// primary key column name(first one for composite key), if missing - empty
+		std::vector<std::string> primary_key; /// all primary key columns in key order, if missing - empty
+		std::vector<index_meta> indexes;      /// loaded only on request, see with_indexes of load_session_meta/load_table_meta
 	};
 	
 	///loads column list from session.
+	///schema - database name("main", "temp", attached name), if empty - table is looked up as sqlite does for unqualified names:
+	///temp, main, then attached databases.
 	///table must exists, otherwise sqlite3yaw::sqlite_error will be thrown
-	void load_table_fields(session & ses, table_meta & meta);
-	///loads information about table by table_name
+	void load_table_fields(session & ses, table_meta & meta, const std::string & schema = "");
+	///loads index list of table into meta.indexes, schema - same as for load_table_fields
+	void load_table_indexes(session & ses, table_meta & meta, const std::string & schema = "");
+	///loads information about table by table_name: fields, and indexes if with_indexes(1 + number of indexes pragmas more)
+	///schema - same as for load_table_fields
 	///table must exists, otherwise sqlite3yaw::sqlite_error will be thrown
-	table_meta load_table_meta(session & ses, const std::string & table_name);
-	///loads list of table metadata from session
-	std::vector<table_meta> load_session_meta(session & ses);
+	table_meta load_table_meta(session & ses, const std::string & table_name, bool with_indexes = false, const std::string & schema = "");
+	///loads list of table metadata of main database from session.
+	///all tables are loaded with one query over sqlite_master joined with pragma_table_info(and one more with
+	///pragma_index_list if with_indexes) table valued functions(sqlite 3.16+), on older sqlite falls back to per table pragmas
+	std::vector<table_meta> load_session_meta(session & ses, bool with_indexes = false);
 }
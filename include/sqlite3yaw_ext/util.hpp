@@ -3,6 +3,10 @@
 #include <iterator>
 #include <algorithm>
 #include <cassert>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <boost/range.hpp>
 #include <boost/range/algorithm.hpp>
@@ -133,22 +137,101 @@ namespace sqlite3yaw
 		return command;
 	}
 
+	namespace detail
+	{
+		/// true if T is char range(std::string, const char *, char array, etc) - single sql name,
+		/// false for range of char ranges - list of sql names
+		template <class Type>
+		struct is_sql_name : std::is_same<
+			std::decay_t<decltype(*boost::begin(boost::as_literal(std::declval<const Type &>())))>, char> {};
+
+		template <class PkCharRange>
+		inline auto append_key_columns(const PkCharRange & pk, std::string & command)
+			-> std::enable_if_t<is_sql_name<PkCharRange>::value>
+		{
+			escape_sql_name(boost::as_literal(pk), std::back_inserter(command));
+		}
+
+		template <class PkRange>
+		inline auto append_key_columns(const PkRange & pk, std::string & command)
+			-> std::enable_if_t<not is_sql_name<PkRange>::value>
+		{
+			join_sql_names(pk, ", ", command);
+		}
+
+		/// appends "<key> = ? and <key> = ? ..."
+		template <class PkCharRange>
+		inline auto append_key_condition(const PkCharRange & pk, std::string & command)
+			-> std::enable_if_t<is_sql_name<PkCharRange>::value>
+		{
+			escape_sql_name(boost::as_literal(pk), std::back_inserter(command));
+			command += " = ?";
+		}
+
+		template <class PkRange>
+		inline auto append_key_condition(const PkRange & pk, std::string & command)
+			-> std::enable_if_t<not is_sql_name<PkRange>::value>
+		{
+			assert(!boost::empty(pk));
+			for (const auto & col : pk)
+			{
+				escape_sql_name(boost::as_literal(col), std::back_inserter(command));
+				command += " = ? and ";
+			}
+
+			command.resize(command.size() - 5); //delete extra " and "
+		}
+
+		/// true if pred holds for some key column, pk is either one char range or range of char ranges
+		template <class PkCharRange, class Pred>
+		inline auto any_key_column(const PkCharRange & pk, Pred pred)
+			-> std::enable_if_t<is_sql_name<PkCharRange>::value, bool>
+		{
+			return pred(boost::as_literal(pk));
+		}
+
+		template <class PkRange, class Pred>
+		inline auto any_key_column(const PkRange & pk, Pred pred)
+			-> std::enable_if_t<not is_sql_name<PkRange>::value, bool>
+		{
+			for (const auto & col : pk)
+				if (pred(boost::as_literal(col))) return true;
+
+			return false;
+		}
+	}
+
+	/// primary key columns of table without copying: meta.primary_key, or meta.pk if only it is filled(manually built meta).
+	/// returned range references meta
+	inline boost::iterator_range<const std::string *> primary_key_range(const table_meta & meta)
+	{
+		if (!meta.primary_key.empty() || meta.pk.empty())
+			return {meta.primary_key.data(), meta.primary_key.data() + meta.primary_key.size()};
+
+		return {&meta.pk, &meta.pk + 1};
+	}
+
+	/// primary key columns of table: meta.primary_key, or meta.pk if only it is filled(manually built meta)
+	inline std::vector<std::string> primary_key_columns(const table_meta & meta)
+	{
+		auto pk = primary_key_range(meta);
+		return std::vector<std::string>(pk.begin(), pk.end());
+	}
+
 	/// creates update command, with binding places
-	/// <update_word> <table> set <colName> = ? ...
-	/// where is not added!
+	/// <update_word> <table> set <colName> = ? ... where <pk> = ? [and <pk2> = ? ...]
 	/// colNames - SinglePass range, whose elements is some char range
+	/// pk - char range(single key column) or range of char ranges(composite key)
 	template <class UpdateWordRange, class CharRange, class SinglePassRange, class PkCharRange>
 	std::string custom_update_command(const UpdateWordRange & update_word, const CharRange & table_name,
 	                                  const SinglePassRange & col_names, const PkCharRange & pk)
 	{
 		auto command = custom_update_command(update_word, table_name, col_names);
-		auto pkr = boost::as_literal(pk);
 		command += " where ";
-		escape_sql_name(pkr, std::back_inserter(command));
-		command += " = ?";
+		detail::append_key_condition(pk, command);
 
 		return command;
-	}	
+	}
 
 	/// creates update command, with binding places
 	/// update <table> set <colName> = ? ...
@@ -161,8 +244,9 @@ namespace sqlite3yaw
 	}
 
 	/// creates update command, with binding places
-	/// update <table> set <colName> = ? ... where <pk> = ?
+	/// update <table> set <colName> = ? ... where <pk> = ? [and <pk2> = ? ...]
 	/// colNames - SinglePass range, whose elements is some char range
+	/// pk - char range(single key column) or range of char ranges(composite key)
 	template <class CharRange, class SinglePassRange, class PkCharRange>
 	inline std::string update_command(const CharRange & table_name, const SinglePassRange & col_names, const PkCharRange & pk)
 	{
@@ -202,12 +286,75 @@ namespace sqlite3yaw
 		return command;
 	}
 
+	/// creates multi-row insert command, with binding places
+	/// <insert_word> into table(<colName>, <colName>, ...) values(?,?,...), (?,?,...), ... - nrows times
+	/// colNames - SinglePass range, whose elements is some char range
+	template <class InsertWordRange, class CharRange, class SinglePassRange>
+	std::string custom_insert_command(const InsertWordRange & insert_word, const CharRange & table_name,
+	                                  const SinglePassRange & col_names, std::size_t nrows)
+	{
+		assert(nrows > 0);
+		auto command = custom_insert_command(insert_word, table_name, col_names);
+		if (nrows == 1) return command;
+
+		// command ends with "values ( ?,?,...)", replicate that group
+		auto pos = command.rfind(" ( ");
+		std::string row = command.substr(pos);
+		row.front() = ',';
+
+		command.reserve(command.size() + row.size() * (nrows - 1));
+		for (std::size_t i = 1; i < nrows; ++i)
+			command += row;
+
+		return command;
+	}
+
 	template <class CharRange, class SinglePassRange>
 	inline std::string insert_command(const CharRange & table_name, const SinglePassRange & col_names)
 	{
 		return custom_insert_command("insert", table_name, col_names);
 	}
 
+	template <class CharRange, class SinglePassRange>
+	inline std::string insert_command(const CharRange & table_name, const SinglePassRange & col_names, std::size_t nrows)
+	{
+		return custom_insert_command("insert", table_name, col_names, nrows);
+	}
+
+	/// creates native upsert command(sqlite 3.24+), with binding places
+	/// insert into table(<colName>, ...) values(?,...) on conflict(<pk>, ...) do update set <colName> = excluded.<colName>, ...
+	/// key columns are not included into set clause, if there is nothing to update - do nothing is used
+	/// colNames - ForwardRange range, whose elements is some char range
+	/// pk - char range(single key column) or range of char ranges(composite key)
+	template <class CharRange, class ForwardRange, class PkCharRange>
+	std::string upsert_command(const CharRange & table_name, const ForwardRange & col_names, const PkCharRange & pk)
+	{
+		auto command = custom_insert_command("insert", table_name, col_names);
+		auto bi = std::back_inserter(command);
+		ext::ctpred::equal_to<metastr_traits> eq;
+
+		command += " on conflict(";
+		detail::append_key_columns(pk, command);
+		command += ") do ";
+
+		bool first = true;
+		for (const auto & col : col_names)
+		{
+			auto colr = boost::as_literal(col);
+			if (detail::any_key_column(pk, [&](auto keyr) { return eq(colr, keyr); })) continue;
+
+			command += first ? "update set " : ", ";
+			first = false;
+
+			escape_sql_name(colr, bi);
+			command += " = excluded.";
+			escape_sql_name(colr, bi);
+		}
+
+		if (first) command += "nothing";
+		return command;
+	}
+
 	template <class CharRange, class SinglePassRange>
 	std::string select_command(const CharRange & table_name, const SinglePassRange & col_names)
 	{
@@ -222,6 +369,7 @@ namespace sqlite3yaw
 	}
 
 	/// inserts data tagval_range into table represented by meta
+	/// statement is prepared via session::prepare_cached
 	/// 
 	/// tagval_range - range of tagval, which is pair or pair like class
 	///   first element is some char range, representing tag
@@ -230,17 +378,16 @@ namespace sqlite3yaw
 	void insert_record(session & ses, const table_meta & meta, const ForwardRange & tagval_range)
 	{
 		auto command = insert_command(meta.table_name, tagval_range | ext::firsts);
-		auto stmt = ses.prepare(command);
-		boost::for_each(tagval_range | ext::seconds, auto_binder(stmt));
+		auto stmt = ses.prepare_cached(std::move(command));
+		boost::for_each(tagval_range | ext::seconds, auto_binder(*stmt));
 
-		stmt.step();
-		stmt.finalize();
+		stmt->step();
 	}
 
 	/// updates data tagval_range into table represented by meta by primary key
-	/// primary key is taken from meta.pk
-	/// calling this function on table which is not having primary key - logic_error
-	/// calling this function whith tagval_range not having primary key field - { err_action(meta.pk); return; }
+	/// primary key is taken from meta.primary_key(composite keys are supported), statement is prepared via session::prepare_cached
+	/// calling this function on table which is not having primary key - invalid_argument
+	/// calling this function whith tagval_range not having some primary key field - runtime_error
 	/// 
 	/// tagval_range - range of tagval, which is pair or pair like class
 	///   first element is some char range, representing tag
@@ -248,24 +395,27 @@ namespace sqlite3yaw
 	template <class ForwardRange>
 	void update_record(session & ses, const table_meta & meta, const ForwardRange & tagval_range)
 	{
-		assert(!meta.pk.empty());
-		if (meta.pk.empty())
+		auto pk = primary_key_range(meta);
+		if (pk.empty())
 			throw std::invalid_argument("update_record called on table which does not have primary key");
 
-		auto isPk = std::bind(ext::ctpred::equal_to<metastr_traits>(), meta.pk, std::placeholders::_1);
-		auto iPkTagVal = boost::find_if(tagval_range | ext::firsts, isPk).base();
-		assert(iPkTagVal != boost::end(tagval_range));
-		if (iPkTagVal == boost::end(tagval_range))
-			throw std::runtime_error("missing pk");
-
-		auto command = update_command(meta.table_name, tagval_range | ext::firsts, meta.pk);
-		auto stmt = ses.prepare(command);
-		sqlite3yaw::auto_binder binder(stmt);
+		auto command = update_command(meta.table_name, tagval_range | ext::firsts, pk);
+		auto stmt = ses.prepare_cached(std::move(command));
+		sqlite3yaw::auto_binder binder(*stmt);
 		boost::for_each(tagval_range | ext::seconds, std::ref(binder));
-		binder(std::get<1>(*iPkTagVal));
 
-		stmt.step();
-		stmt.finalize();
+		ext::ctpred::equal_to<metastr_traits> eq;
+		for (const auto & key : pk)
+		{
+			auto isKey = [&eq, &key](const auto & name) { return eq(key, name); };
+			auto iPkTagVal = boost::find_if(tagval_range | ext::firsts, isKey).base();
+			if (iPkTagVal == boost::end(tagval_range))
+				throw std::runtime_error("update_record: missing pk field " + key);
+
+			binder(std::get<1>(*iPkTagVal));
+		}
+
+		stmt->step();
 	}
 
 	///tries update record with update_record(ses, meta, tagval_range)
@@ -0,0 +1,524 @@
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include <sqlite3yaw.hpp>
+#include <sqlite3yaw_ext/util.hpp>
+#include <sqlite3yaw_ext/arrow.hpp>
+
+namespace sqlite3yaw
+{
+	namespace
+	{
+		// buffers of empty arrays must not be null
+		const std::int64_t empty_buffer[1] = {0};
+
+		const char * arrow_format(int type)
+		{
+			switch (type)
+			{
+				case SQLITE_INTEGER: return "l";
+				case SQLITE_FLOAT:   return "g";
+				case SQLITE_BLOB:    return "z";
+				default:             return "u";
+			}
+		}
+
+		const void * nonnull(const void * ptr)
+		{
+			return ptr ? ptr : empty_buffer;
+		}
+
+		/************************************************************************/
+		/*                       schema export                                  */
+		/************************************************************************/
+		struct schema_data
+		{
+			std::string name;
+			std::vector<ArrowSchema> children;
+			std::vector<ArrowSchema *> child_ptrs;
+		};
+
+		void release_schema(ArrowSchema * schema)
+		{
+			auto * data = static_cast<schema_data *>(schema->private_data);
+			for (auto * child : data->child_ptrs)
+				if (child->release) child->release(child);
+
+			delete data;
+			schema->release = nullptr;
+		}
+
+		void init_schema(ArrowSchema & schema, schema_data * data, const char * format, std::int64_t flags)
+		{
+			std::memset(&schema, 0, sizeof(schema));
+			schema.format = format;
+			schema.name = data->name.c_str();
+			schema.flags = flags;
+			schema.n_children = static_cast<std::int64_t>(data->child_ptrs.size());
+			schema.children = data->child_ptrs.empty() ? nullptr : data->child_ptrs.data();
+			schema.release = &release_schema;
+			schema.private_data = data;
+		}
+
+		/// exports struct schema of batch columns names with given column types, types.size() == batch.column_count()
+		void export_struct_schema(const column_batch & batch, const std::vector<int> & types, ArrowSchema * out)
+		{
+			auto data = std::make_unique<schema_data>();
+			std::size_t count = batch.column_count();
+			data->children.resize(count);
+			data->child_ptrs.resize(count);
+
+			std::vector<std::unique_ptr<schema_data>> child_data(count);
+			for (std::size_t idx = 0; idx < count; ++idx)
+			{
+				child_data[idx] = std::make_unique<schema_data>();
+				child_data[idx]->name = batch[idx].name;
+			}
+
+			for (std::size_t idx = 0; idx < count; ++idx)
+			{
+				init_schema(data->children[idx], child_data[idx].release(), arrow_format(types[idx]), ARROW_FLAG_NULLABLE);
+				data->child_ptrs[idx] = &data->children[idx];
+			}
+
+			init_schema(*out, data.release(), "+s", 0);
+		}
+
+		/************************************************************************/
+		/*                       array export                                   */
+		/************************************************************************/
+		struct column_data
+		{
+			batch_column col;
+			const void * buffers[3];
+		};
+
+		struct struct_data
+		{
+			const void * buffers[1] = {nullptr};
+			std::vector<ArrowArray> children;
+			std::vector<ArrowArray *> child_ptrs;
+		};
+
+		void release_column(ArrowArray * array)
+		{
+			delete static_cast<column_data *>(array->private_data);
+			array->release = nullptr;
+		}
+
+		void release_struct(ArrowArray * array)
+		{
+			auto * data = static_cast<struct_data *>(array->private_data);
+			for (auto * child : data->child_ptrs)
+				if (child->release) child->release(child);
+
+			delete data;
+			array->release = nullptr;
+		}
+
+		/// moves column out of batch into child array
+		void export_column(batch_column & col, std::size_t rows, ArrowArray & out)
+		{
+			if (col.type == 0)
+			{
+				// no type known yet - all NULL utf8, following batches are read as text
+				col.type = SQLITE_TEXT;
+				col.offsets.assign(rows + 1, 0);
+			}
+
+			auto data = std::make_unique<column_data>();
+			data->col = std::move(col);
+			col.name = data->col.name;
+			col.type = data->col.type;
+
+			auto & moved = data->col;
+			data->buffers[0] = moved.null_count ? moved.validity.data() : nullptr;
+			switch (moved.type)
+			{
+				case SQLITE_INTEGER:
+					data->buffers[1] = nonnull(moved.ints.data());
+					break;
+				case SQLITE_FLOAT:
+					data->buffers[1] = nonnull(moved.doubles.data());
+					break;
+				default:
+					data->buffers[1] = nonnull(moved.offsets.data());
+					data->buffers[2] = nonnull(moved.bytes.data());
+					break;
+			}
+
+			std::memset(&out, 0, sizeof(out));
+			out.length = static_cast<std::int64_t>(rows);
+			out.null_count = static_cast<std::int64_t>(moved.null_count);
+			out.n_buffers = moved.type == SQLITE_INTEGER || moved.type == SQLITE_FLOAT ? 2 : 3;
+			out.buffers = data->buffers;
+			out.release = &release_column;
+			out.private_data = data.release();
+		}
+
+		/************************************************************************/
+		/*                       stream export                                  */
+		/************************************************************************/
+		struct stream_data
+		{
+			statement * stmt;
+			std::size_t batch_rows;
+			column_batch batch;
+			bool fetched = false;   // batch holds fetched, not yet exported rows
+			bool started = false;   // first batch was fetched
+			std::vector<int> types; // column types of stream schema, fixed by first get_schema/get_next
+			std::string error;
+		};
+
+		/// type of column as exported, column without known type is exported as utf8
+		int exported_type(int type)
+		{
+			return type == 0 ? SQLITE_TEXT : type;
+		}
+
+		void stream_fix_types(stream_data & data)
+		{
+			if (!data.types.empty()) return;
+			for (std::size_t idx = 0; idx < data.batch.column_count(); ++idx)
+				data.types.push_back(exported_type(data.batch[idx].type));
+		}
+
+		/// column of following batch can be promoted from INTEGER to FLOAT(REAL value in NUMERIC column or expression),
+		/// schema can't change in stream, and truncating values would lose data
+		void stream_check_types(stream_data & data)
+		{
+			for (std::size_t idx = 0; idx < data.types.size(); ++idx)
+			{
+				auto & col = data.batch[idx];
+				if (exported_type(col.type) != data.types[idx])
+					throw std::runtime_error("export_arrow_stream: column '" + col.name + "' type changed from " +
+					                         arrow_format(data.types[idx]) + " to " + arrow_format(col.type) +
+					                         " after first batch, cast it in query or increase batch_rows");
+			}
+		}
+
+		template <class Functor>
+		int stream_call(ArrowArrayStream * stream, Functor && func) noexcept
+		{
+			auto * data = static_cast<stream_data *>(stream->private_data);
+			try
+			{
+				func(*data);
+				return 0;
+			}
+			catch (std::bad_alloc &)
+			{
+				data->error = "out of memory";
+				return ENOMEM;
+			}
+			catch (std::exception & ex)
+			{
+				data->error = ex.what();
+				return EIO;
+			}
+		}
+
+		void stream_prefetch(stream_data & data)
+		{
+			if (data.started) return;
+
+			fetch_batch(*data.stmt, data.batch, data.batch_rows);
+			data.fetched = data.started = true;
+		}
+
+		int stream_get_schema(ArrowArrayStream * stream, ArrowSchema * out)
+		{
+			return stream_call(stream, [out](stream_data & data)
+			{
+				stream_prefetch(data);
+				stream_fix_types(data);
+				// schema must not change during stream life, it's built from types fixed by first batch
+				export_struct_schema(data.batch, data.types, out);
+			});
+		}
+
+		int stream_get_next(ArrowArrayStream * stream, ArrowArray * out)
+		{
+			return stream_call(stream, [out](stream_data & data)
+			{
+				stream_prefetch(data);
+				if (!data.fetched)
+					fetch_batch(*data.stmt, data.batch, data.batch_rows);
+
+				data.fetched = false;
+				if (data.batch.empty())
+				{
+					// end of stream
+					std::memset(out, 0, sizeof(*out));
+					return;
+				}
+
+				stream_fix_types(data);
+				stream_check_types(data);
+				export_arrow_array(data.batch, out);
+			});
+		}
+
+		const char * stream_get_last_error(ArrowArrayStream * stream)
+		{
+			auto * data = static_cast<stream_data *>(stream->private_data);
+			return data->error.empty() ? nullptr : data->error.c_str();
+		}
+
+		void stream_release(ArrowArrayStream * stream)
+		{
+			delete static_cast<stream_data *>(stream->private_data);
+			stream->release = nullptr;
+		}
+
+		/************************************************************************/
+		/*                       insert                                         */
+		/************************************************************************/
+		enum class arrow_kind
+		{
+			null, boolean, int8, uint8, int16, uint16, int32, uint32, int64, uint64,
+			float32, float64, utf8, large_utf8, binary, large_binary,
+		};
+
+		arrow_kind parse_format(const char * format)
+		{
+			std::string fmt = format;
+			if (fmt.size() == 1)
+			{
+				switch (fmt[0])
+				{
+					case 'n': return arrow_kind::null;
+					case 'b': return arrow_kind::boolean;
+					case 'c': return arrow_kind::int8;
+					case 'C': return arrow_kind::uint8;
+					case 's': return arrow_kind::int16;
+					case 'S': return arrow_kind::uint16;
+					case 'i': return arrow_kind::int32;
+					case 'I': return arrow_kind::uint32;
+					case 'l': return arrow_kind::int64;
+					case 'L': return arrow_kind::uint64;
+					case 'f': return arrow_kind::float32;
+					case 'g': return arrow_kind::float64;
+					case 'u': return arrow_kind::utf8;
+					case 'U': return arrow_kind::large_utf8;
+					case 'z': return arrow_kind::binary;
+					case 'Z': return arrow_kind::large_binary;
+				}
+			}
+
+			// temporal types as integers: date32 days, date64 milliseconds, time32/time64, timestamps and durations
+			if (fmt == "tdD" || fmt == "tts" || fmt == "ttm") return arrow_kind::int32;
+			if (fmt == "tdm" || fmt == "ttu" || fmt == "ttn") return arrow_kind::int64;
+			if (fmt.compare(0, 2, "ts") == 0 || fmt.compare(0, 2, "tD") == 0) return arrow_kind::int64;
+
+			throw std::invalid_argument("insert_arrow: arrow format '" + fmt + "' is not supported");
+		}
+
+		struct column_reader
+		{
+			arrow_kind kind;
+			std::int64_t offset;
+			const std::uint8_t * validity;
+			const void * values;     // values or offsets
+			const char * bytes;      // utf8/binary data
+
+			template <class Type>
+			Type at(std::int64_t idx) const { return static_cast<const Type *>(values)[idx]; }
+
+			static bool bit(const std::uint8_t * bitmap, std::int64_t idx) { return bitmap[idx / 8] & (1u << (idx % 8)); }
+
+			template <class Offset>
+			void bind_bytes(statement & stmt, int param, std::int64_t idx, bool text) const
+			{
+				auto begin = at<Offset>(idx), end = at<Offset>(idx + 1);
+				// data buffer of empty values may be null, sqlite binds null pointer as NULL, not ''
+				auto * data = static_cast<const char *>(nonnull(bytes));
+				if (text)
+					stmt.bind_text(param, data + begin, ToInt(static_cast<std::size_t>(end - begin)), false);
+				else
+					stmt.bind_blob(param, data + begin, static_cast<std::size_t>(end - begin), false);
+			}
+
+			static void bind_uint64(statement & stmt, int param, std::uint64_t val)
+			{
+				if (val > static_cast<std::uint64_t>(std::numeric_limits<sqlite3_int64>::max()))
+					throw std::out_of_range("insert_arrow: uint64 value " + std::to_string(val) + " of parameter " +
+					                        std::to_string(param) + " does not fit into sqlite integer");
+
+				stmt.bind_int64(param, static_cast<sqlite3_int64>(val));
+			}
+
+			void bind(statement & stmt, int param, std::int64_t row) const
+			{
+				std::int64_t idx = offset + row;
+				if (kind == arrow_kind::null || (validity && !bit(validity, idx)))
+					return stmt.bind_null(param);
+
+				switch (kind)
+				{
+					case arrow_kind::boolean:      return stmt.bind_int(param, bit(static_cast<const std::uint8_t *>(values), idx));
+					case arrow_kind::int8:         return stmt.bind_int(param, at<std::int8_t>(idx));
+					case arrow_kind::uint8:        return stmt.bind_int(param, at<std::uint8_t>(idx));
+					case arrow_kind::int16:        return stmt.bind_int(param, at<std::int16_t>(idx));
+					case arrow_kind::uint16:       return stmt.bind_int(param, at<std::uint16_t>(idx));
+					case arrow_kind::int32:        return stmt.bind_int(param, at<std::int32_t>(idx));
+					case arrow_kind::uint32:       return stmt.bind_int64(param, at<std::uint32_t>(idx));
+					case arrow_kind::int64:        return stmt.bind_int64(param, at<std::int64_t>(idx));
+					case arrow_kind::uint64:       return bind_uint64(stmt, param, at<std::uint64_t>(idx));
+					case arrow_kind::float32:      return stmt.bind_double(param, at<float>(idx));
+					case arrow_kind::float64:      return stmt.bind_double(param, at<double>(idx));
+					case arrow_kind::utf8:         return bind_bytes<std::int32_t>(stmt, param, idx, true);
+					case arrow_kind::large_utf8:   return bind_bytes<std::int64_t>(stmt, param, idx, true);
+					case arrow_kind::binary:       return bind_bytes<std::int32_t>(stmt, param, idx, false);
+					case arrow_kind::large_binary: return bind_bytes<std::int64_t>(stmt, param, idx, false);
+					case arrow_kind::null:         return stmt.bind_null(param);
+				}
+			}
+		};
+
+		column_reader make_reader(const ArrowSchema & schema, const ArrowArray & array)
+		{
+			if (schema.dictionary || array.dictionary)
+				throw std::invalid_argument(std::string("insert_arrow: dictionary encoded column '") + (schema.name ? schema.name : "") + "' is not supported");
+
+			column_reader reader;
+			reader.kind = parse_format(schema.format);
+			reader.offset = array.offset;
+			reader.validity = nullptr;
+			reader.values = nullptr;
+			reader.bytes = nullptr;
+			if (reader.kind == arrow_kind::null)
+				return reader;
+
+			reader.validity = array.null_count != 0 ? static_cast<const std::uint8_t *>(array.buffers[0]) : nullptr;
+			reader.values = array.buffers[1];
+			if (array.n_buffers > 2)
+				reader.bytes = static_cast<const char *>(array.buffers[2]);
+
+			return reader;
+		}
+	}
+
+	void export_arrow_schema(const column_batch & batch, ArrowSchema * out)
+	{
+		std::vector<int> types;
+		types.reserve(batch.column_count());
+		for (std::size_t idx = 0; idx < batch.column_count(); ++idx)
+			types.push_back(batch[idx].type);
+
+		export_struct_schema(batch, types, out);
+	}
+
+	void export_arrow_array(column_batch & batch, ArrowArray * out)
+	{
+		auto data = std::make_unique<struct_data>();
+		std::size_t count = batch.column_count(), rows = batch.size();
+		data->children.resize(count);
+		data->child_ptrs.resize(count);
+
+		try
+		{
+			for (std::size_t idx = 0; idx < count; ++idx)
+			{
+				data->child_ptrs[idx] = &data->children[idx];
+				export_column(batch[idx], rows, data->children[idx]);
+			}
+		}
+		catch (...)
+		{
+			// already exported children own moved out columns, not yet exported ones have null release
+			for (auto & child : data->children)
+				if (child.release) child.release(&child);
+			throw;
+		}
+
+		std::memset(out, 0, sizeof(*out));
+		out->length = static_cast<std::int64_t>(rows);
+		out->n_buffers = 1;
+		out->n_children = static_cast<std::int64_t>(count);
+		out->buffers = data->buffers;
+		out->children = count ? data->child_ptrs.data() : nullptr;
+		out->release = &release_struct;
+		out->private_data = data.release();
+
+		batch.clear();
+	}
+
+	void export_arrow_stream(statement & stmt, ArrowArrayStream * out, std::size_t batch_rows)
+	{
+		if (batch_rows == 0)
+			throw std::invalid_argument("export_arrow_stream: batch_rows must be positive");
+
+		auto data = std::make_unique<stream_data>();
+		data->stmt = &stmt;
+		data->batch_rows = batch_rows;
+
+		out->get_schema = &stream_get_schema;
+		out->get_next = &stream_get_next;
+		out->get_last_error = &stream_get_last_error;
+		out->release = &stream_release;
+		out->private_data = data.release();
+	}
+
+	std::size_t insert_arrow(statement & stmt, const ArrowSchema & schema, const ArrowArray & array)
+	{
+		if (std::strcmp(schema.format, "+s") != 0)
+			throw std::invalid_argument("insert_arrow: record batch must be struct array");
+		if (schema.n_children != array.n_children)
+			throw std::invalid_argument("insert_arrow: schema and array have different column count");
+		if (stmt.bind_parameter_count() != array.n_children)
+			throw std::invalid_argument("insert_arrow: statement has " + std::to_string(stmt.bind_parameter_count()) +
+			                            " parameters, batch has " + std::to_string(array.n_children) + " columns");
+
+		std::vector<column_reader> readers;
+		readers.reserve(static_cast<std::size_t>(array.n_children));
+		for (std::int64_t idx = 0; idx < array.n_children; ++idx)
+			readers.push_back(make_reader(*schema.children[idx], *array.children[idx]));
+
+		auto * struct_validity = array.null_count != 0 ? static_cast<const std::uint8_t *>(array.buffers[0]) : nullptr;
+		int count = static_cast<int>(readers.size());
+		try
+		{
+			for (std::int64_t row = 0; row < array.length; ++row)
+			{
+				std::int64_t idx = array.offset + row;
+				bool null_row = struct_validity && !column_reader::bit(struct_validity, idx);
+
+				for (int col = 0; col < count; ++col)
+				{
+					if (null_row) stmt.bind_null(col + 1);
+					else          readers[col].bind(stmt, col + 1, idx);
+				}
+
+				stmt.step();
+				stmt.reset();
+			}
+		}
+		catch (...)
+		{
+			// bindings point into caller's arrow buffers
+			stmt.reset();
+			sqlite3_clear_bindings(stmt.native());
+			throw;
+		}
+
+		stmt.clear_bindings();
+		return static_cast<std::size_t>(array.length);
+	}
+
+	std::size_t insert_arrow(session & ses, const std::string & table, const ArrowSchema & schema, const ArrowArray & array)
+	{
+		std::vector<std::string> names;
+		names.reserve(static_cast<std::size_t>(schema.n_children));
+		for (std::int64_t idx = 0; idx < schema.n_children; ++idx)
+			names.push_back(schema.children[idx]->name ? schema.children[idx]->name : "");
+
+		auto stmt = ses.prepare_cached(insert_command(table, names));
+		return insert_arrow(*stmt, schema, array);
+	}
+}
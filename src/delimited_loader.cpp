@@ -0,0 +1,370 @@
+#include <sqlite3yaw.hpp>
+#include <sqlite3yaw_ext/delimited_loader.hpp>
+#include <sqlite3yaw_ext/util.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SQLITE3YAW_LOADER_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace sqlite3yaw
+{
+	namespace
+	{
+		struct field
+		{
+			const char * data;
+			int size;              // -1 - null
+		};
+
+		struct chunk
+		{
+			std::vector<field> fields;           // rows * ncols fields
+			std::deque<std::string> unescaped;   // storage for fields with escaped quotes, deque - references are stable
+			std::size_t rows = 0;
+		};
+
+		/// finds first c1 or c2 in [first, last), returns last if none
+		const char * find_either(const char * first, const char * last, char c1, char c2)
+		{
+#ifdef SQLITE3YAW_LOADER_SSE2
+			const __m128i v1 = _mm_set1_epi8(c1);
+			const __m128i v2 = _mm_set1_epi8(c2);
+
+			for (; last - first >= 16; first += 16)
+			{
+				__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+				__m128i eq = _mm_or_si128(_mm_cmpeq_epi8(block, v1), _mm_cmpeq_epi8(block, v2));
+				unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+				if (mask)
+				{
+#ifdef _MSC_VER
+					unsigned long pos;
+					_BitScanForward(&pos, mask);
+					return first + pos;
+#else
+					return first + __builtin_ctz(mask);
+#endif
+				}
+			}
+#endif
+			for (; first != last; ++first)
+				if (*first == c1 || *first == c2)
+					return first;
+
+			return last;
+		}
+
+		BOOST_NORETURN void throw_malformed(std::uint64_t line, const char * what)
+		{
+			throw std::runtime_error("load_delimited: line " + std::to_string(line) + ": " + what);
+		}
+
+		/// field sizes are bound through int, sqlite3_bind_text/blob take int length
+		int field_size(std::uint64_t line, std::ptrdiff_t size)
+		{
+			if (size > std::numeric_limits<int>::max())
+				throw_malformed(line, "field exceeds 2GB");
+
+			return static_cast<int>(size);
+		}
+
+		/// splits delimited text into rows of fields
+		class parser
+		{
+			const char * cur;
+			const char * last;
+			const delimited_load_options & opts;
+			std::uint64_t line = 1;
+
+		private:
+			void parse_quoted(chunk & ch)
+			{
+				const char * first = ++cur;
+				bool escaped = false;
+				for (;;)
+				{
+					cur = static_cast<const char *>(std::memchr(cur, opts.quote, last - cur));
+					if (!cur) throw_malformed(line, "unterminated quoted field");
+					if (cur + 1 == last || cur[1] != opts.quote) break;
+
+					escaped = true; // "" inside quoted field
+					cur += 2;
+				}
+
+				const char * qend = cur++;
+				const int size = field_size(line, qend - first);
+				line += std::count(first, qend, '\n');
+
+				if (!escaped)
+				{
+					ch.fields.push_back({first, size});
+					return;
+				}
+
+				auto & str = ch.unescaped.emplace_back();
+				str.reserve(qend - first);
+				for (const char * p = first; p != qend; ++p)
+				{
+					str.push_back(*p);
+					if (*p == opts.quote) ++p;
+				}
+
+				ch.fields.push_back({str.data(), static_cast<int>(str.size())});
+			}
+
+			void parse_plain(chunk & ch)
+			{
+				const char * first = cur;
+				cur = find_either(cur, last, opts.delimiter, '\n');
+
+				const char * fend = cur;
+				if (fend != first && fend[-1] == '\r' && (fend == last || *fend == '\n'))
+					--fend;
+
+				int size = field_size(line, fend - first);
+				ch.fields.push_back({first, size == 0 && opts.empty_as_null ? -1 : size});
+			}
+
+		public:
+			parser(const char * first, const char * last_, const delimited_load_options & opts_)
+				: cur(first), last(last_), opts(opts_) {}
+
+			bool at_end() const noexcept { return cur == last; }
+			std::uint64_t line_number() const noexcept { return line; }
+
+			/// parses one line, fields are appended to ch.fields, returns number of parsed fields.
+			/// empty lines are skipped, returns 0 at end of input
+			std::size_t parse_row(chunk & ch)
+			{
+				while (cur != last && (*cur == '\n' || (*cur == '\r' && cur + 1 != last && cur[1] == '\n')))
+				{
+					if (*cur == '\r') ++cur;
+					++cur, ++line;
+				}
+
+				if (cur == last) return 0;
+
+				std::size_t count = 0;
+				for (;;)
+				{
+					if (opts.quote && *cur == opts.quote)
+						parse_quoted(ch);
+					else
+						parse_plain(ch);
+
+					++count;
+					if (cur != last && *cur == '\r' && cur + 1 != last && cur[1] == '\n') ++cur;
+					if (cur == last) break;
+					if (*cur == '\n') { ++cur, ++line; break; }
+					if (*cur != opts.delimiter) throw_malformed(line, "garbage after quoted field");
+
+					++cur;
+					if (cur == last) // trailing delimiter - empty last field
+					{
+						ch.fields.push_back({cur, opts.empty_as_null ? -1 : 0});
+						++count;
+						break;
+					}
+				}
+
+				return count;
+			}
+		};
+
+		/// bounded single producer/single consumer queue of parsed chunks
+		class chunk_queue
+		{
+			std::mutex mutex;
+			std::condition_variable cond;
+			std::deque<chunk> chunks;
+			std::size_t capacity;
+			bool finished = false;
+			bool cancelled = false;
+			std::exception_ptr error;
+
+		public:
+			chunk_queue(std::size_t capacity_) : capacity(capacity_ ? capacity_ : 1) {}
+
+			/// returns false if consumer cancelled loading
+			bool push(chunk && ch)
+			{
+				std::unique_lock<std::mutex> lk(mutex);
+				cond.wait(lk, [this] { return cancelled || chunks.size() < capacity; });
+				if (cancelled) return false;
+
+				chunks.push_back(std::move(ch));
+				cond.notify_all();
+				return true;
+			}
+
+			void finish(std::exception_ptr ex = nullptr)
+			{
+				std::lock_guard<std::mutex> lk(mutex);
+				finished = true;
+				error = ex;
+				cond.notify_all();
+			}
+
+			void cancel()
+			{
+				std::lock_guard<std::mutex> lk(mutex);
+				cancelled = true;
+				cond.notify_all();
+			}
+
+			/// returns false when all chunks are consumed, rethrows producer error
+			bool pop(chunk & ch)
+			{
+				std::unique_lock<std::mutex> lk(mutex);
+				cond.wait(lk, [this] { return finished || !chunks.empty(); });
+				if (chunks.empty())
+				{
+					if (error) std::rethrow_exception(error);
+					return false;
+				}
+
+				ch = std::move(chunks.front());
+				chunks.pop_front();
+				cond.notify_all();
+				return true;
+			}
+		};
+
+		std::uint64_t file_size(const std::string & path)
+		{
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if (!file) throw std::runtime_error("load_delimited: can't open " + path);
+			return static_cast<std::uint64_t>(file.tellg());
+		}
+
+		void produce(parser & p, std::size_t ncols, const delimited_load_options & opts, chunk_queue & queue) noexcept
+		{
+			try
+			{
+				while (!p.at_end())
+				{
+					chunk ch;
+					ch.fields.reserve(opts.chunk_rows * ncols);
+					while (ch.rows < opts.chunk_rows)
+					{
+						auto line = p.line_number();
+						auto count = p.parse_row(ch);
+						if (count == 0) break;
+						if (count != ncols)
+							throw_malformed(line, ("expected " + std::to_string(ncols) + " fields, got " + std::to_string(count)).c_str());
+
+						++ch.rows;
+					}
+
+					if (ch.rows && !queue.push(std::move(ch)))
+						return;
+				}
+
+				queue.finish();
+			}
+			catch (...)
+			{
+				queue.finish(std::current_exception());
+			}
+		}
+	}
+
+	delimited_load_stats load_delimited(session & ses, const table_meta & meta, const std::string & path,
+	                                    const delimited_load_options & opts_)
+	{
+		namespace ipc = boost::interprocess;
+		auto start = std::chrono::steady_clock::now();
+
+		delimited_load_options opts = opts_;
+		if (opts.chunk_rows == 0) opts.chunk_rows = 1;
+
+		delimited_load_stats stats;
+		stats.bytes = file_size(path);
+		if (stats.bytes == 0) return stats;
+
+		ipc::file_mapping mapping(path.c_str(), ipc::read_only);
+		ipc::mapped_region region(mapping, ipc::read_only);
+		auto * first = static_cast<const char *>(region.get_address());
+		parser p(first, first + region.get_size(), opts);
+
+		std::vector<std::string> columns;
+		if (opts.has_header)
+		{
+			chunk header;
+			p.parse_row(header);
+			for (auto & f : header.fields)
+				columns.emplace_back(f.data, f.size < 0 ? 0 : f.size);
+		}
+		else
+		{
+			for (auto & f : meta.fields)
+				columns.push_back(f.name);
+		}
+
+		if (columns.empty())
+			return stats;
+
+		auto stmt = ses.prepare(insert_command(meta.table_name, columns));
+		const std::size_t ncols = columns.size();
+
+		chunk_queue queue(opts.queue_depth);
+		std::thread producer(produce, std::ref(p), ncols, std::cref(opts), std::ref(queue));
+
+		try
+		{
+			chunk ch;
+			while (queue.pop(ch))
+			{
+				immediate_transaction tr(ses);
+				auto it = ch.fields.begin();
+				for (std::size_t row = 0; row < ch.rows; ++row)
+				{
+					for (int idx = 1; idx <= static_cast<int>(ncols); ++idx, ++it)
+					{
+						if (it->size < 0)
+							stmt.bind_null(idx);
+						else
+							stmt.bind_text(idx, it->data, it->size, false);
+					}
+
+					stmt.step();
+					stmt.reset();
+				}
+
+				tr.commit();
+				stats.rows += ch.rows;
+			}
+		}
+		catch (...)
+		{
+			queue.cancel();
+			producer.join();
+			throw;
+		}
+
+		producer.join();
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+}
@@ -0,0 +1,48 @@
+#include <sqlite3yaw.hpp>
+#include <sqlite3yaw_ext/meta_cache.hpp>
+
+namespace sqlite3yaw
+{
+	table_meta_cache::table_meta_cache(session & ses_)
+		: ses(&ses_), version_stmt(ses_.prepare("PRAGMA main.schema_version"))
+	{
+
+	}
+
+	int table_meta_cache::read_schema_version()
+	{
+		version_stmt.step();
+		int ver = version_stmt.column_int(0);
+		version_stmt.reset();
+		return ver;
+	}
+
+	bool table_meta_cache::revalidate()
+	{
+		int ver = read_schema_version();
+		if (ver == version)
+			return false;
+
+		tables.clear();
+		version = ver;
+		return true;
+	}
+
+	void table_meta_cache::invalidate() noexcept
+	{
+		tables.clear();
+		version = -1;
+	}
+
+	const table_meta & table_meta_cache::get(const std::string & table_name)
+	{
+		revalidate();
+
+		auto it = tables.find(table_name);
+		if (it != tables.end())
+			return it->second;
+
+		auto meta = load_table_meta(*ses, table_name, false, "main");
+		return tables.emplace(table_name, std::move(meta)).first->second;
+	}
+}
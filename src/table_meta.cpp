@@ -1,61 +1,282 @@
 #include <sqlite3yaw.hpp>
 #include <sqlite3yaw_ext/table_meta.hpp>
+#include <sqlite3yaw_ext/pooled_table_meta.hpp>
 #include <sqlite3yaw_ext/util.hpp>
-#include <functional>
+#include <algorithm>
+#include <future>
+#include <optional>
+#include <unordered_map>
 
 namespace sqlite3yaw
 {
-	void load_table_fields(session & ses, table_meta & meta)
+	namespace
+	{
+		typedef std::vector<std::pair<sqlite3_int64, table_meta>> rowid_meta_vector;
+
+		/// pragma_table_info, pragma_index_list, pragma_index_info table valued functions are available since 3.16.0
+		bool table_valued_pragmas_supported()
+		{
+			return sqlite3_libversion_number() >= 3016000;
+		}
+
+		/// fills meta.primary_key and meta.pk from fields pk_pos
+		void fill_primary_key(table_meta & meta)
+		{
+			std::vector<const field_meta *> pkfields;
+			for (auto & f : meta.fields)
+				if (f.pk_pos) pkfields.push_back(&f);
+
+			std::sort(pkfields.begin(), pkfields.end(),
+				[](auto * f1, auto * f2) { return f1->pk_pos < f2->pk_pos; });
+
+			meta.primary_key.clear();
+			for (auto * f : pkfields)
+				meta.primary_key.push_back(f->name);
+
+			meta.pk = meta.primary_key.empty() ? std::string() : meta.primary_key.front();
+		}
+
+		/// builds "PRAGMA [schema.]pragma(name)" command, name and schema are escaped
+		std::string pragma_command(const char * pragma, const std::string & name, const std::string & schema)
+		{
+			std::string cmd = "PRAGMA ";
+			if (!schema.empty()) {
+				sqlite3yaw::escape_sql_name(schema, std::back_inserter(cmd));
+				cmd += '.';
+			}
+
+			cmd += pragma;
+			cmd += '(';
+			sqlite3yaw::escape_sql_name(name, std::back_inserter(cmd));
+			cmd += ')';
+			return cmd;
+		}
+
+		/// reads table_info row columns: name, type, notnull, dflt_value, pk - starting from column first
+		void read_field(statement & stmt, int first, field_meta & fm)
+		{
+			sqlite3yaw::get(stmt, first + 0, fm.name);
+			sqlite3yaw::get(stmt, first + 1, fm.type);
+			fm.notnull = stmt.column_int(first + 2) != 0;
+			sqlite3yaw::get(stmt, first + 3, fm.def_val);
+			fm.pk_pos = stmt.column_int(first + 4);
+		}
+
+		/// loads tables metadata with 2 queries(1 without indexes), only tables with rowid % parts == part are loaded
+		rowid_meta_vector load_tables_part(session & ses, std::size_t part, std::size_t parts, bool with_indexes)
+		{
+			std::string filter;
+			if (parts > 1)
+				filter = " and m.rowid % " + std::to_string(parts) + " = " + std::to_string(part);
+
+			rowid_meta_vector result;
+			std::unordered_map<sqlite3_int64, std::size_t> positions;
+
+			// both queries must read same snapshot, otherwise concurrent schema change can pair fields and indexes
+			// of different schema states or add a table between them. caller transaction, if any, is used as is
+			std::optional<transaction> tr;
+			if (with_indexes && ses.get_autocommit())
+				tr.emplace(ses);
+
+			auto stmt = ses.prepare(
+				"select m.rowid, m.name, p.name, p.type, p.\"notnull\", p.dflt_value, p.pk "
+				"from sqlite_master m join pragma_table_info(m.name, 'main') p "
+				"where m.type = 'table'" + filter + " order by m.rowid, p.cid");
+
+			while (stmt.step()) {
+				auto rowid = stmt.column_int64(0);
+				if (result.empty() || result.back().first != rowid) {
+					positions.emplace(rowid, result.size());
+					result.emplace_back(rowid, table_meta());
+					sqlite3yaw::get(stmt, 1, result.back().second.table_name);
+				}
+
+				field_meta fm;
+				read_field(stmt, 2, fm);
+				result.back().second.fields.push_back(std::move(fm));
+			}
+			stmt.finalize();
+
+			if (!with_indexes) {
+				for (auto & rm : result)
+					fill_primary_key(rm.second);
+
+				return result;
+			}
+
+			stmt = ses.prepare(
+				"select m.rowid, il.name, il.\"unique\", il.origin, il.partial, ii.name "
+				"from sqlite_master m join pragma_index_list(m.name, 'main') il join pragma_index_info(il.name, 'main') ii "
+				"where m.type = 'table'" + filter + " order by m.rowid, il.seq, ii.seqno");
+
+			table_meta * table = nullptr;
+			sqlite3_int64 table_rowid = 0;
+			while (stmt.step()) {
+				auto rowid = stmt.column_int64(0);
+				if (!table || table_rowid != rowid) {
+					// table not seen by first query(schema changed between queries), skip it
+					auto it = positions.find(rowid);
+					table_rowid = rowid;
+					table = it == positions.end() ? nullptr : &result[it->second].second;
+				}
+
+				if (!table) continue;
+
+				auto * name = stmt.column_text(1);
+				if (table->indexes.empty() || table->indexes.back().name != name) {
+					index_meta im;
+					im.name = name;
+					im.unique = stmt.column_int(2) != 0;
+					sqlite3yaw::get(stmt, 3, im.origin);
+					im.partial = stmt.column_int(4) != 0;
+					table->indexes.push_back(std::move(im));
+				}
+
+				table->indexes.back().columns.push_back(stmt.column_string(5));
+			}
+			stmt.finalize();
+			if (tr) tr->commit();
+
+			for (auto & rm : result)
+				fill_primary_key(rm.second);
+
+			return result;
+		}
+
+		/// per table pragmas loading, for sqlite older than 3.16
+		std::vector<table_meta> load_session_meta_fallback(session & ses, bool with_indexes)
+		{
+			std::vector<table_meta> meta;
+			auto stmt = ses.prepare("select name from sqlite_master where type = 'table'");
+
+			while (stmt.step()) {
+				table_meta tableInfo;
+				sqlite3yaw::get(stmt, 0, tableInfo.table_name);
+				meta.push_back(tableInfo);
+			}
+			stmt.finalize();
+
+			for (auto & tm : meta) {
+				load_table_fields(ses, tm, "main");
+				if (with_indexes) load_table_indexes(ses, tm, "main");
+			}
+
+			return meta;
+		}
+	}
+
+	void load_table_fields(session & ses, table_meta & meta, const std::string & schema)
 	{
 		if (meta.table_name.empty())
 			throw std::invalid_argument("meta.table_name is empty");
-		
+
 		meta.pk.clear();
 
-		std::string cmd = "PRAGMA table_info(";
-		sqlite3yaw::escape_sql_name(meta.table_name, std::back_inserter(cmd));
-		cmd += ")";
-		
-		auto stmt = ses.prepare(cmd);
+		auto stmt = ses.prepare(pragma_command("table_info", meta.table_name, schema));
+		sqlite3yaw::named_getter get(stmt, {"name", "type", "notnull", "dflt_value", "pk"});
 		while (stmt.step()) {
 			field_meta fm;
-			sqlite3yaw::get(stmt, "name", fm.name);
-			sqlite3yaw::get(stmt, "type", fm.type);
-			sqlite3yaw::get(stmt, "dflt_value", fm.def_val);
-			
-			std::string pk;
-			sqlite3yaw::get(stmt, "pk", pk);
-			
+			get(0, fm.name);
+			get(1, fm.type);
+			int notnull;
+			get(2, notnull);
+			get(3, fm.def_val);
+			get(4, fm.pk_pos);
+			fm.notnull = notnull != 0;
+
 			meta.fields.push_back(std::move(fm));
-			if (pk == "1")
-				meta.pk = meta.fields.back().name;
 		}
 		stmt.finalize();
+
+		fill_primary_key(meta);
 	}
 
-	table_meta load_table_meta(session & ses, const std::string & table_name)
+	void load_table_indexes(session & ses, table_meta & meta, const std::string & schema)
+	{
+		if (meta.table_name.empty())
+			throw std::invalid_argument("meta.table_name is empty");
+
+		meta.indexes.clear();
+
+		auto stmt = ses.prepare(pragma_command("index_list", meta.table_name, schema));
+		// origin and partial columns are present since sqlite 3.8.9
+		int originIdx = stmt.column_index("origin");
+		int partialIdx = stmt.column_index("partial");
+		sqlite3yaw::named_getter get(stmt, {"name", "unique"});
+		while (stmt.step()) {
+			index_meta im;
+			int unique;
+			get(0, im.name);
+			get(1, unique);
+			im.unique = unique != 0;
+			if (originIdx >= 0)  sqlite3yaw::get(stmt, originIdx, im.origin);
+			if (partialIdx >= 0) im.partial = stmt.column_int(partialIdx) != 0;
+
+			meta.indexes.push_back(std::move(im));
+		}
+		stmt.finalize();
+
+		for (auto & im : meta.indexes) {
+			stmt = ses.prepare(pragma_command("index_info", im.name, schema));
+			int nameIdx = stmt.column_index("name");
+			while (stmt.step())
+				im.columns.push_back(stmt.column_string(nameIdx));
+			stmt.finalize();
+		}
+	}
+
+	table_meta load_table_meta(session & ses, const std::string & table_name, bool with_indexes, const std::string & schema)
 	{
 		table_meta meta;
 		meta.table_name = table_name;
-		load_table_fields(ses, meta);
+		load_table_fields(ses, meta, schema);
+		if (with_indexes) load_table_indexes(ses, meta, schema);
 		return meta;
 	}
 
-	std::vector<table_meta> load_session_meta(session & ses)
+	std::vector<table_meta> load_session_meta(session & ses, bool with_indexes)
 	{
+		if (!table_valued_pragmas_supported())
+			return load_session_meta_fallback(ses, with_indexes);
+
 		std::vector<table_meta> meta;
-		auto stmt = ses.prepare("select name from sqlite_master where type = 'table'");
+		for (auto & rm : load_tables_part(ses, 0, 1, with_indexes))
+			meta.push_back(std::move(rm.second));
 
-		while (stmt.step()) {
-			table_meta tableInfo;
-			sqlite3yaw::get(stmt, 0, tableInfo.table_name);
-			meta.push_back(tableInfo);
+		return meta;
+	}
+
+	std::vector<table_meta> load_session_meta(session_pool & pool, std::size_t threads, bool with_indexes)
+	{
+		if (!table_valued_pragmas_supported())
+			return load_session_meta_fallback(*pool.reader(), with_indexes);
+
+		if (threads == 0) threads = pool.readers_count();
+		if (threads <= 1)
+			return load_session_meta(*pool.reader(), with_indexes);
+
+		std::vector<std::future<rowid_meta_vector>> parts;
+		for (std::size_t part = 0; part < threads; ++part) {
+			parts.push_back(std::async(std::launch::async, [&pool, part, threads, with_indexes] {
+				auto reader = pool.reader();
+				return load_tables_part(*reader, part, threads, with_indexes);
+			}));
 		}
-		stmt.finalize();
-		
-		using namespace std::placeholders;
-		std::for_each(meta.begin(), meta.end(),
-			std::bind(load_table_fields, std::ref(ses), _1));
+
+		rowid_meta_vector all;
+		for (auto & f : parts) {
+			auto part = f.get();
+			std::move(part.begin(), part.end(), std::back_inserter(all));
+		}
+
+		// keep sqlite_master order, same as single threaded version
+		std::sort(all.begin(), all.end(),
+			[](auto & rm1, auto & rm2) { return rm1.first < rm2.first; });
+
+		std::vector<table_meta> meta;
+		meta.reserve(all.size());
+		for (auto & rm : all)
+			meta.push_back(std::move(rm.second));
 
 		return meta;
 	}